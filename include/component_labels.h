@@ -0,0 +1,36 @@
+#pragma once
+#include <set>
+#include <vector>
+
+#include "types.h"
+
+// Connected components as flat arrays. labels[v] is the component of vertex v,
+// components are numbered 0 to num_components-1. When the lists are built the
+// vertices of component c are vertices[offsets[c]] up to vertices[offsets[c+1]-1].
+// Queries reuse the arrays of the ComponentLabels they are given.
+struct ComponentLabels {
+  std::vector<node_id_t> labels;
+  node_id_t num_components = 0;
+  std::vector<node_id_t> offsets;
+  std::vector<node_id_t> vertices;
+
+  // Groups the vertices by component with a counting sort over the labels
+  void build_lists() {
+    offsets.assign(num_components+1, 0);
+    for (node_id_t label : labels)
+      offsets[label+1]++;
+    for (node_id_t c = 0; c < num_components; c++)
+      offsets[c+1] += offsets[c];
+    vertices.resize(labels.size());
+    std::vector<node_id_t> next(offsets.begin(), offsets.end()-1);
+    for (node_id_t v = 0; v < labels.size(); v++)
+      vertices[next[labels[v]]++] = v;
+  }
+
+  std::vector<std::set<node_id_t>> to_sets() const {
+    std::vector<std::set<node_id_t>> cc(num_components);
+    for (node_id_t v = 0; v < labels.size(); v++)
+      cc[labels[v]].insert(cc[labels[v]].end(), v);
+    return cc;
+  }
+};
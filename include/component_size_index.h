@@ -0,0 +1,52 @@
+#pragma once
+#include <algorithm>
+#include <cassert>
+#include <functional>
+#include <map>
+#include <vector>
+
+#include "types.h"
+
+// Counts the components of each size as a forest is linked and cut, so the
+// largest components are found without scanning them. There are at most
+// O(sqrt(n)) distinct sizes, so every change is cheap.
+class ComponentSizeIndex {
+  // Number of components of each size, largest first
+  std::map<node_id_t, node_id_t, std::greater<node_id_t>> counts;
+
+  void add(node_id_t size) { counts[size]++; }
+  void remove(node_id_t size) {
+    auto it = counts.find(size);
+    assert(it != counts.end());
+    if (--it->second == 0)
+      counts.erase(it);
+  }
+
+public:
+  // Starts with every vertex in a component of its own
+  ComponentSizeIndex(node_id_t num_nodes) {
+    if (num_nodes > 0) counts[1] = num_nodes;
+  }
+
+  // Two components of the given sizes were linked into one
+  void merge(node_id_t size1, node_id_t size2) {
+    remove(size1);
+    remove(size2);
+    add(size1 + size2);
+  }
+  // A component was cut into two of the given sizes
+  void split(node_id_t size1, node_id_t size2) {
+    remove(size1 + size2);
+    add(size1);
+    add(size2);
+  }
+
+  node_id_t largest() const { return counts.empty() ? 0 : counts.begin()->first; }
+  // Returns the sizes of the k largest components, largest first
+  std::vector<node_id_t> top_k(size_t k) const {
+    std::vector<node_id_t> sizes;
+    for (auto it = counts.begin(); it != counts.end() && sizes.size() < k; ++it)
+      sizes.insert(sizes.end(), std::min((size_t)it->second, k - sizes.size()), it->first);
+    return sizes;
+  }
+};
@@ -0,0 +1,232 @@
+#pragma once
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+
+#include "types.h"
+
+// Maps each edge of an ETT vertex to the skiplist occurrence that starts it.
+// Edges are keyed by the other endpoint's vertex id and the nullptr edge, the
+// sentinel, gets its own field. Up to inline_capacity edges are kept in small
+// inline arrays, larger vertices switch to an open addressing table with
+// linear probing that is kept at most half full.
+template <typename Vertex, typename Occurrence>
+class EdgeIndex {
+  static constexpr uint32_t inline_capacity = 4;
+  // Tables shrink back to the inline arrays once this few edges are left
+  static constexpr uint32_t inline_threshold = 2;
+  static constexpr node_id_t empty_key = (node_id_t)-1;
+
+  Occurrence* sentinel = nullptr;
+  uint32_t num_edges = 0;
+  // Number of table slots, 0 while the inline arrays are in use
+  uint32_t capacity = 0;
+  union {
+    struct {
+      node_id_t keys[inline_capacity];
+      Occurrence* vals[inline_capacity];
+    } small;
+    struct {
+      node_id_t* keys;
+      Occurrence** vals;
+    } table;
+  };
+
+  uint32_t slot_of(node_id_t key) const {
+    // Fibonacci hashing, capacity is a power of 2
+    return (uint32_t)((key * 0x9E3779B97F4A7C15ULL) >> 32) & (capacity-1);
+  }
+
+  // Returns the slot holding key, or the empty slot where it would go
+  uint32_t probe(node_id_t key) const {
+    uint32_t slot = slot_of(key);
+    while (table.keys[slot] != key && table.keys[slot] != empty_key)
+      slot = (slot+1) & (capacity-1);
+    return slot;
+  }
+
+  void free_table() {
+    if (capacity)
+      std::free(table.vals);
+  }
+
+  // Moves every edge into a table with the given number of slots, or the inline arrays for 0
+  void resize(uint32_t new_capacity) {
+    assert(new_capacity == 0 ? num_edges <= inline_capacity : num_edges < new_capacity/2+1);
+    node_id_t old_keys[inline_capacity];
+    Occurrence* old_vals[inline_capacity];
+    node_id_t* keys = capacity ? table.keys : old_keys;
+    Occurrence** vals = capacity ? table.vals : old_vals;
+    uint32_t old_slots = capacity ? capacity : num_edges;
+    if (!capacity) {
+      std::memcpy(old_keys, small.keys, sizeof(old_keys));
+      std::memcpy(old_vals, small.vals, sizeof(old_vals));
+    }
+    capacity = new_capacity;
+    if (new_capacity) {
+      // Keys and values share one allocation
+      void* block = std::malloc(new_capacity*(sizeof(node_id_t)+sizeof(Occurrence*)));
+      table.vals = static_cast<Occurrence**>(block);
+      table.keys = reinterpret_cast<node_id_t*>(table.vals + new_capacity);
+      std::memset(table.keys, 0xFF, new_capacity*sizeof(node_id_t));
+    }
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < old_slots; i++) {
+      if (keys[i] == empty_key) continue;
+      if (new_capacity) {
+        uint32_t slot = probe(keys[i]);
+        table.keys[slot] = keys[i];
+        table.vals[slot] = vals[i];
+      } else {
+        small.keys[count] = keys[i];
+        small.vals[count] = vals[i];
+      }
+      count++;
+    }
+    if (keys != old_keys)
+      std::free(vals);
+  }
+
+public:
+  EdgeIndex() {}
+  EdgeIndex(const EdgeIndex& other) : sentinel(other.sentinel), num_edges(other.num_edges), capacity(other.capacity) {
+    if (capacity) {
+      size_t bytes = capacity*(sizeof(node_id_t)+sizeof(Occurrence*));
+      table.vals = static_cast<Occurrence**>(std::malloc(bytes));
+      table.keys = reinterpret_cast<node_id_t*>(table.vals + capacity);
+      std::memcpy(table.vals, other.table.vals, bytes);
+    } else {
+      small = other.small;
+    }
+  }
+  EdgeIndex(EdgeIndex&& other) noexcept : sentinel(other.sentinel), num_edges(other.num_edges), capacity(other.capacity) {
+    if (capacity)
+      table = other.table;
+    else
+      small = other.small;
+    other.capacity = 0;
+    other.num_edges = 0;
+    other.sentinel = nullptr;
+  }
+  EdgeIndex& operator=(const EdgeIndex&) = delete;
+  ~EdgeIndex() { free_table(); }
+
+  // Returns the occurrence for the edge to other, nullptr for the sentinel, or nullptr if there is none
+  Occurrence* find(const Vertex* other) const {
+    if (!other)
+      return sentinel;
+    node_id_t key = other->vertex;
+    if (!capacity) {
+      for (uint32_t i = 0; i < num_edges; i++)
+        if (small.keys[i] == key)
+          return small.vals[i];
+      return nullptr;
+    }
+    uint32_t slot = probe(key);
+    return table.keys[slot] == key ? table.vals[slot] : nullptr;
+  }
+
+  // Adds the occurrence unless the edge already has one, returns the occurrence stored for the edge
+  Occurrence* insert(const Vertex* other, Occurrence* occurrence) {
+    if (Occurrence* existing = find(other))
+      return existing;
+    if (!other)
+      return sentinel = occurrence;
+    node_id_t key = other->vertex;
+    assert(key != empty_key);
+    if (!capacity && num_edges == inline_capacity)
+      resize(4*inline_capacity);
+    else if (capacity && 2*(num_edges+1) > capacity)
+      resize(2*capacity);
+    if (!capacity) {
+      small.keys[num_edges] = key;
+      small.vals[num_edges] = occurrence;
+    } else {
+      uint32_t slot = probe(key);
+      table.keys[slot] = key;
+      table.vals[slot] = occurrence;
+    }
+    num_edges++;
+    return occurrence;
+  }
+
+  void erase(const Vertex* other) {
+    if (!other) {
+      sentinel = nullptr;
+      return;
+    }
+    node_id_t key = other->vertex;
+    if (!capacity) {
+      for (uint32_t i = 0; i < num_edges; i++) {
+        if (small.keys[i] == key) {
+          num_edges--;
+          small.keys[i] = small.keys[num_edges];
+          small.vals[i] = small.vals[num_edges];
+          return;
+        }
+      }
+      return;
+    }
+    uint32_t slot = probe(key);
+    if (table.keys[slot] != key)
+      return;
+    // Backward shift deletion, move later entries of the probe run into the hole
+    uint32_t hole = slot;
+    for (uint32_t next = (hole+1) & (capacity-1); table.keys[next] != empty_key; next = (next+1) & (capacity-1)) {
+      uint32_t home = slot_of(table.keys[next]);
+      // Entries whose home lies cyclically in (hole, next] have to stay where they are
+      bool stays = hole <= next ? (hole < home && home <= next) : (hole < home || home <= next);
+      if (!stays) {
+        table.keys[hole] = table.keys[next];
+        table.vals[hole] = table.vals[next];
+        hole = next;
+      }
+    }
+    table.keys[hole] = empty_key;
+    num_edges--;
+    if (num_edges <= inline_threshold)
+      resize(0);
+    else if (capacity > 4*inline_capacity && 8*num_edges < capacity)
+      resize(capacity/2);
+  }
+
+  // Removes every edge, the sentinel included
+  void clear() {
+    free_table();
+    capacity = 0;
+    num_edges = 0;
+    sentinel = nullptr;
+  }
+
+  bool empty() const { return !sentinel && num_edges == 0; }
+  // Number of edges including the sentinel
+  size_t size() const { return num_edges + (sentinel != nullptr); }
+
+  // Returns any occurrence, the sentinel if there is one, nullptr if empty
+  Occurrence* any() const {
+    if (sentinel || !num_edges)
+      return sentinel;
+    if (!capacity)
+      return small.vals[0];
+    for (uint32_t i = 0; ; i++)
+      if (table.keys[i] != empty_key)
+        return table.vals[i];
+  }
+
+  // Calls f on every occurrence, the sentinel included
+  template <typename F>
+  void for_each(F f) const {
+    if (sentinel)
+      f(sentinel);
+    if (!capacity) {
+      for (uint32_t i = 0; i < num_edges; i++)
+        f(small.vals[i]);
+      return;
+    }
+    for (uint32_t i = 0; i < capacity; i++)
+      if (table.keys[i] != empty_key)
+        f(table.vals[i]);
+  }
+};
@@ -1,8 +1,13 @@
 #pragma once
+#include <cassert>
 #include <iostream>
-#include <unordered_map>
+#include <iterator>
+#include <memory>
+#include <new>
+#include "edge_index.h"
 
 #include <skiplist.h>
+#include "component_labels.h"
 
 
 class EulerTourNode {
@@ -11,31 +16,40 @@ class EulerTourNode {
   FRIEND_TEST(SkipListSuite, join_split_test);
   FRIEND_TEST(GraphTiersSuite, mini_correctness_test);
   
-  std::unordered_map<EulerTourNode*, SkipListNode*> edges;
+  EdgeIndex<EulerTourNode, SkipListNode> edges;
 
-  Sketch* temp_sketch = nullptr;
-  long seed = 0;
+  SkipListAllocator* allocator = nullptr;
+  SketchPool* sketch_pool = nullptr;
+  uint64_t* list_epoch = nullptr;
 
-  SkipListNode* make_edge(EulerTourNode* other, Sketch* temp_sketch);
-  void delete_edge(EulerTourNode* other, Sketch* temp_sketch);
+  SkipListNode* make_edge(EulerTourNode* other, SkipListNode* temp_agg);
+  void delete_edge(EulerTourNode* other, SkipListNode* temp_agg);
+  // Returns the occurrence that starts this vertex's tour if there is one, otherwise any occurrence
+  SkipListNode* front_occurrence();
 
 public:
   const node_id_t vertex = 0;
   const uint32_t tier = 0;
   SkipListNode* allowed_caller = nullptr;
 
-  EulerTourNode(long seed, node_id_t vertex, uint32_t tier);
-  EulerTourNode(long seed);
+  EulerTourNode(node_id_t vertex, uint32_t tier, SkipListAllocator* allocator, SketchPool* sketch_pool, uint64_t* list_epoch);
+  EulerTourNode(SkipListAllocator* allocator, SketchPool* sketch_pool, uint64_t* list_epoch);
   ~EulerTourNode();
-  bool link(EulerTourNode& other, Sketch* temp_sketch);
-  bool cut(EulerTourNode& other, Sketch* temp_sketch);
+  bool link(EulerTourNode& other, SkipListNode* temp_agg);
+  bool cut(EulerTourNode& other, SkipListNode* temp_agg);
 
   bool isvalid() const;
 
   Sketch* get_sketch(SkipListNode* caller);
   SkipListNode* update_sketch(vec_t update_idx);
 
+  // Forgets every occurrence without freeing it and gives the vertex a new sentinel.
+  // Only for the tree to call once it has freed all of its skiplist nodes.
+  void reset();
+
   SkipListNode* get_root();
+  // Returns the sentinel that ends this vertex's tour if it has one, only one vertex per tree does
+  SkipListNode* get_sentinel() {return edges.find(nullptr);};
 
   Sketch* get_aggregate();
   uint32_t get_size();
@@ -43,24 +57,119 @@ public:
 
   std::set<EulerTourNode*> get_component();
 
-  long get_seed() {return seed;};
+  SkipListAllocator* get_allocator() {return allocator;};
+  SketchPool* get_sketch_pool() {return sketch_pool;};
+  uint64_t* get_list_epoch() {return list_epoch;};
 
   friend std::ostream& operator<<(std::ostream& os, const EulerTourNode& ett);
 };
 
+// The ETT nodes of one tier, indexed by vertex. They either get an array of their
+// own or every stride-th slot of an array shared with other tiers, which lays the
+// nodes out vertex-major with all tiers of a vertex next to each other.
+class EulerTourNodeArray {
+  EulerTourNode* nodes = nullptr;
+  node_id_t num_nodes = 0;
+  node_id_t capacity = 0;
+  uint32_t stride = 1;
+  bool owns_storage = false;
+
+public:
+  class iterator {
+    EulerTourNode* node;
+    uint32_t stride;
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = EulerTourNode;
+    using difference_type = std::ptrdiff_t;
+    using pointer = EulerTourNode*;
+    using reference = EulerTourNode&;
+
+    iterator(EulerTourNode* node, uint32_t stride) : node(node), stride(stride) {}
+    reference operator*() const { return *node; }
+    pointer operator->() const { return node; }
+    iterator& operator++() { node += stride; return *this; }
+    iterator operator++(int) { iterator prev = *this; node += stride; return prev; }
+    bool operator==(const iterator& other) const { return node == other.node; }
+    bool operator!=(const iterator& other) const { return node != other.node; }
+  };
+
+  // Raw storage for count nodes, shared by the tiers that are placed in it
+  static EulerTourNode* allocate(size_t count) { return std::allocator<EulerTourNode>().allocate(count); }
+  static void deallocate(EulerTourNode* storage, size_t count) { std::allocator<EulerTourNode>().deallocate(storage, count); }
+
+  EulerTourNodeArray() {}
+  EulerTourNodeArray(EulerTourNodeArray&& other) noexcept;
+  EulerTourNodeArray& operator=(const EulerTourNodeArray&) = delete;
+  ~EulerTourNodeArray();
+
+  // Allocates an array of its own for num_nodes nodes
+  void reserve(node_id_t num_nodes);
+  // Puts the nodes in every stride-th slot of storage, which the caller owns
+  void place(EulerTourNode* storage, node_id_t num_nodes, uint32_t stride);
+  template <typename... Args>
+  EulerTourNode& emplace_back(Args&&... args) {
+    assert(num_nodes < capacity);
+    EulerTourNode* node = new (&nodes[(size_t)num_nodes*stride]) EulerTourNode(std::forward<Args>(args)...);
+    num_nodes++;
+    return *node;
+  }
+
+  EulerTourNode& operator[](node_id_t i) { return nodes[(size_t)i*stride]; }
+  const EulerTourNode& operator[](node_id_t i) const { return nodes[(size_t)i*stride]; }
+  size_t size() const { return num_nodes; }
+  iterator begin() const { return iterator(nodes, stride); }
+  iterator end() const { return iterator(nodes + (size_t)num_nodes*stride, stride); }
+};
+
+// Root of one endpoint's tree right after an update of a batch, with the
+// tree's size and the sample of its aggregate sketch at that point
+typedef struct {
+  SkipListNode* root;
+  uint32_t size;
+  SampleResult sample;
+} BatchRoot;
+
 class EulerTourTree {
-  Sketch* temp_sketch;
+  // Owns the memory of every skiplist node in this tree
+  std::unique_ptr<SkipListAllocator> allocator;
+  // Recycles the aggregate sketches of this tree
+  std::unique_ptr<SketchPool> sketch_pool;
+  // Holds the aggregate of a vertex while it has no occurrences during a link or cut
+  std::unique_ptr<SkipListNode> temp_agg;
+  // Counts the joins and splits of this tree's skiplists, which invalidate cached roots
+  std::unique_ptr<uint64_t> list_epoch;
+  // Pending updates and delta sketches of update_sketches_batch for one skiplist level,
+  // as (node, update index) and (node, sketch) pairs. Kept to reuse their memory.
+  std::vector<std::pair<SkipListNode*, uint32_t>> batch_updates, next_batch_updates;
+  std::vector<std::pair<SkipListNode*, Sketch*>> batch_deltas, next_batch_deltas;
+
+  // Destroys the skiplist of every tree one node at a time
+  void free_lists();
 public:
-  std::vector<EulerTourNode> ett_nodes;
+  EulerTourNodeArray ett_nodes;
   
-  EulerTourTree(node_id_t num_nodes, uint32_t tier_num, int seed);
+  // If node_storage is given the nodes go in every node_stride-th slot of it instead of an array of their own
+  EulerTourTree(node_id_t num_nodes, uint32_t tier_num, int seed, int buffer_cap = skiplist_buffer_cap,
+      EulerTourNode* node_storage = nullptr, uint32_t node_stride = 1);
+  EulerTourTree(EulerTourTree&&) = default;
+  ~EulerTourTree();
+
+  // Cuts every edge and zeroes every aggregate, as if the tree was just constructed.
+  // Skiplist nodes, sketches and buffers are all taken back at once and reused.
+  void reset();
 
   void link(node_id_t u, node_id_t v);
   void cut(node_id_t u, node_id_t v);
   bool has_edge(node_id_t u, node_id_t v);
   SkipListNode* update_sketch(node_id_t u, vec_t update_idx);
   std::pair<SkipListNode*, SkipListNode*> update_sketches(node_id_t u, node_id_t v, vec_t update_idx);
+  // Same as calling update_sketches for each update in order, the updates must not change the forest.
+  // roots[2*i] and roots[2*i+1] receive the roots of the endpoints of update i as they are after it.
+  void update_sketches_batch(const GraphUpdate* updates, uint32_t num_updates, BatchRoot* roots);
   SkipListNode* get_root(node_id_t u);
   Sketch* get_aggregate(node_id_t u);
   uint32_t get_size(node_id_t u);
+  // Labels every vertex with its tree, and groups the vertices by tree if with_lists is set
+  void get_cc_labels(ComponentLabels& cc, bool with_lists = false);
 };
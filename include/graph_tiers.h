@@ -26,7 +26,11 @@ extern std::atomic<long> num_sketch_batches;
 // and the spanning forest of the entire graph
 class GraphTiers {
   FRIEND_TEST(GraphTiersSuite, mini_correctness_test);
+  FRIEND_TEST(GraphTiersSuite, omp_path_length_test);
+  FRIEND_TEST(GraphTiersSuite, cc_labels_test);
 private:
+  // Nodes of every tier when they are stored vertex-major, nullptr otherwise
+  EulerTourNode* ett_node_storage = nullptr;
   std::vector<EulerTourTree> ett;  // one ETT for each tier
   std::vector<SkipListNode*> root_nodes;
   LinkCutTree link_cut_tree;
@@ -36,11 +40,20 @@ public:
   GraphTiers(node_id_t num_nodes);
   ~GraphTiers();
 
+  // Deletes every edge, leaving the tiers as they were right after construction.
+  // Much faster than constructing new GraphTiers, and reuses all of the memory.
+  void reset();
+
   // apply an edge update
   void update(GraphUpdate update);
 
   // query for the connected components of the graph
   std::vector<std::set<node_id_t>> get_cc();
+  // query for the connected components as a label per vertex, and a list per component if with_lists is set
+  void get_cc_labels(ComponentLabels& cc, bool with_lists = false);
+
+  // query for the number of connected components, in constant time
+  node_id_t num_components();
 
   // query for if a is connected to b
   bool is_connected(node_id_t a, node_id_t b);
@@ -1,8 +1,10 @@
 #pragma once
 
 #include <gtest/gtest.h>
+#include <limits>
 #include "types.h"
 #include "util.h"
+#include "component_labels.h"
 
 #define MAX_UINT64 (std::numeric_limits<uint64_t>::max())
 class LinkCutTree;
@@ -11,45 +13,72 @@ class SplayTree;
 class LinkCutNode {
   FRIEND_TEST(LinkCutTreeSuite, random_links_and_cuts);
 
-  LinkCutNode* parent;
-  LinkCutNode* dparent;
-  LinkCutNode* left;
-  LinkCutNode* right;
-  
-  LinkCutNode* head = this;
-  LinkCutNode* tail = this;
-
-  //Keep a list of edges with weights and up to two preferred edges
-  std::pair<edge_id_t, edge_id_t> preferred_edges = {MAX_UINT64, MAX_UINT64};
-  std::unordered_map<edge_id_t, uint32_t> edges = {};
-  //Maintain an aggregate maximum of the edge weights in the auxilliary tree
+  //Nodes refer to each other by their index in the tree's vector of nodes, nil for none
+  static constexpr uint32_t nil = std::numeric_limits<uint32_t>::max();
+  static constexpr uint32_t reversed_bit = (uint32_t)1 << 31;
+
+  //Index of this node, with the reversed bit set to indicate that the meanings of left and right
+  //are reversed at all nodes in this subtree
+  uint32_t id_and_reversed;
+  uint32_t parent = nil;
+  uint32_t dparent = nil;
+  //Weight of the edge to dparent, so joining paths needs no lookups
+  uint32_t dparent_weight = 0;
+  uint32_t left = nil;
+  uint32_t right = nil;
+
+  //First and last node of this subtree in order, as if this node's reversed flag was not set
+  uint32_t head;
+  uint32_t tail;
+  //Index of the first and last node of this subtree in order
+  uint32_t first() { return this->get_reversed() ? tail : head; }
+  uint32_t last() { return this->get_reversed() ? head : tail; }
+
+  struct PreferredEdge {
+    uint32_t neighbor = nil;
+    uint32_t weight = 0;
+  };
+  //Keep up to two preferred edges along with their weights, so rebuilding the maximum needs no lookups.
+  //A preferred edge that was removed from the forest keeps weight 0 until it stops being preferred.
+  PreferredEdge preferred_edges[2];
+  //Maintain an aggregate maximum of the edge weights in the auxilliary tree. The endpoints of the
+  //maximum edge are kept in either order, and only put in order by get_max_edge.
   uint32_t max = 0;
   edge_id_t max_edge = MAX_UINT64;
-  //Recompute the maximum just for this single node
-  void rebuild_max();
+  //Recompute the maximum, head and tail just for this single node
+  void rebuild_aggregates();
 
-  //Indicates that the meanings of left and right are reversed at all nodes in this subtree
-  bool reversed;
-  //Reverses all of appropriate nodes on the path from the root to this node
-  void correct_reversals();
+  //Swaps the children of this node if it is reversed and passes the reversal on to them
+  void push_down();
 
   void rotate_up();
 
+  uint32_t index() { return id_and_reversed & ~reversed_bit; }
+  //Converts between indices and nodes, the other nodes are found relative to this one
+  LinkCutNode* node_at(uint32_t i) { return i == nil ? nullptr : this - index() + i; }
+  static uint32_t index_of(LinkCutNode* node) { return node ? node->index() : nil; }
+
   public:
+    // Largest number of nodes that can be indexed next to the reversed bit
+    static constexpr node_id_t max_nodes = reversed_bit;
+
+    LinkCutNode(node_id_t id) : id_and_reversed(id), head(id), tail(id) {}
+
     LinkCutNode* splay();
 
     void link_left(LinkCutNode* left);
     void link_right(LinkCutNode* right);
 
     void set_parent(LinkCutNode* parent);
-    void set_dparent(LinkCutNode* dparent);
+    void set_dparent(LinkCutNode* dparent, uint32_t weight);
     
-    void make_preferred_edge(edge_id_t e);
-    void unmake_preferred_edge(edge_id_t e);
-    void insert_edge(edge_id_t e, uint32_t weight);
-    void remove_edge(edge_id_t e);
-    bool has_edge(edge_id_t e);
-    uint32_t get_edge_weight(edge_id_t e);
+    void make_preferred_edge(node_id_t neighbor, uint32_t weight);
+    // Returns the weight the preferred edge had
+    uint32_t unmake_preferred_edge(node_id_t neighbor);
+    // The edge to neighbor was removed from the forest, so it no longer counts towards the maximum
+    void remove_edge_weight(node_id_t neighbor);
+    // Returns the weight of the edge to neighbor if it is preferred or the dparent edge, nullptr otherwise
+    uint32_t* find_edge_weight(node_id_t neighbor);
     void set_max(uint32_t weight);
 
     void set_reversed(bool reversed);
@@ -57,15 +86,16 @@ class LinkCutNode {
     void set_use_edge_up(bool use_edge_up);
     void set_use_edge_down(bool use_edge_down);
     
+    node_id_t get_id() { return index(); }
     LinkCutNode* get_left();
     LinkCutNode* get_right();
     LinkCutNode* get_parent();
     LinkCutNode* get_dparent();
+    uint32_t get_dparent_weight() { return dparent_weight; }
 
+    //First and last node in order of the path represented by this subtree
     LinkCutNode* get_head();
     LinkCutNode* get_tail();
-    LinkCutNode* recompute_head();
-    LinkCutNode* recompute_tail();
     std::pair<edge_id_t, uint32_t> get_max_edge();
     bool get_reversed();
 };
@@ -76,9 +106,12 @@ class LinkCutTree {
   FRIEND_TEST(LinkCutTreeSuite, random_links_and_cuts);
   
   std::vector<LinkCutNode> nodes;
+  // Number of represented trees, every link merges two and every cut splits one
+  node_id_t num_trees;
 
-  // Concatenate the paths with aux trees rooted at v and w and return the root of the combined aux tree
-  LinkCutNode* join(LinkCutNode* v, LinkCutNode* w);
+  // Concatenate the paths with aux trees rooted at v and w, where the edge between them has the given weight,
+  // and return the root of the combined aux tree
+  LinkCutNode* join(LinkCutNode* v, LinkCutNode* w, uint32_t weight);
   // Split the aux tree of the path containing v right after v, and return the roots of the two new aux trees
   std::pair<LinkCutNode*, LinkCutNode*> split(LinkCutNode* v);
   
@@ -89,6 +122,8 @@ class LinkCutTree {
 
   public:
     LinkCutTree(node_id_t num_nodes);
+    // Removes every edge, leaving each node in a tree of its own
+    void reset();
     
     // Given nodes v and w, link the trees containing v and w by adding the edge(v, w)
     void link(node_id_t v, node_id_t w, uint32_t weight);
@@ -96,12 +131,26 @@ class LinkCutTree {
     void cut(node_id_t v, node_id_t w);
 
     void* find_root(node_id_t v);
+    // Number of represented trees, in constant time
+    node_id_t get_num_trees() { return num_trees; }
 
     // Given node v and w return the edge with the maximum weight on the path from v to w and the weight itself
     std::pair<edge_id_t, uint32_t> path_aggregate(node_id_t v, node_id_t w);
+
+    struct CycleQueryResult {
+      bool connected = false;
+      // The edge with the maximum weight on the path and the weight itself, only set if connected
+      edge_id_t max_edge = 0;
+      uint32_t max_weight = 0;
+    };
+    // Given nodes v and w, find whether they are connected and the maximum edge on the cycle that adding
+    // the edge (v, w) would close, with a single evert and expose
+    CycleQueryResult cycle_query(node_id_t v, node_id_t w);
     bool has_edge(node_id_t v1, node_id_t v2);
     uint32_t get_edge_weight(node_id_t v1, node_id_t v2);
 
     // Query for the CC algorithm
     std::vector<std::set<node_id_t>> get_cc();
+    // Labels every node with its represented tree, and groups the nodes by tree if with_lists is set
+    void get_cc_labels(ComponentLabels& cc, bool with_lists = false);
 };
@@ -6,6 +6,7 @@
 #include "types.h"
 #include "euler_tour_tree.h"
 #include "sketchless_euler_tour_tree.h"
+#include "component_size_index.h"
 #include "link_cut_tree.h"
 #include "mpi_functions.h"
 
@@ -57,7 +58,8 @@ class InputNode {
   node_id_t num_nodes;
   uint32_t num_tiers;
   LinkCutTree link_cut_tree;
-  SketchlessEulerTourTree query_ett;
+  AggEulerTourTree<SizeAggregate> query_ett;
+  ComponentSizeIndex component_sizes;
   UpdateMessage* update_buffer;
   int buffer_size;
   int buffer_capacity;
@@ -67,13 +69,22 @@ class InputNode {
   int history_size;
   int isolation_count;
   bool using_sliding_window = false;
+  // Link or cut an edge of the spanning forest in every structure that keeps it
+  void forest_link(node_id_t a, node_id_t b, uint32_t weight);
+  void forest_cut(node_id_t a, node_id_t b);
 public:
-  InputNode(node_id_t num_nodes, uint32_t num_tiers, int batch_size, int seed);
+  InputNode(node_id_t num_nodes, uint32_t num_tiers, int batch_size);
   ~InputNode();
   void update(GraphUpdate update);
   void process_all_updates();
   bool connectivity_query(node_id_t a, node_id_t b);
   std::vector<std::set<node_id_t>> cc_query();
+  // Number of connected components, without traversing them
+  node_id_t num_components();
+  // Number of vertices in the component of v
+  node_id_t component_size(node_id_t v);
+  // Sizes of the k largest components, largest first
+  std::vector<node_id_t> largest_components(size_t k);
   void end();
 };
 
@@ -87,6 +98,8 @@ class TierNode {
   GreedyRefreshMessage* next_sizes_buffer;
   SampleResult* query_result_buffer;
   bool* split_revert_buffer;
+  GraphUpdate* sketch_update_buffer;
+  BatchRoot* batch_roots_buffer;
   bool using_sliding_window = false;
   void update_tier(GraphUpdate update);
   void ett_update_tier(EttUpdateMessage message);
@@ -0,0 +1,42 @@
+#pragma once
+#include <vector>
+
+#include "sketch.h"
+
+// Recycles the aggregate sketches and sketch update buffers of a single EulerTourTree.
+// Released sketches are kept as they are and zeroed in one pass when they
+// are handed out again, so steady state link/cut does no sketch allocation.
+// Not thread safe, each EulerTourTree owns its own pool.
+class SketchPool {
+  std::vector<Sketch*> free_sketches;
+  std::vector<vec_t*> free_buffers;
+  long seed;
+  int buffer_cap;
+  // Every sketch and buffer this pool has had to heap allocate
+  std::vector<Sketch*> sketches;
+  std::vector<vec_t*> buffers;
+
+public:
+  SketchPool(long seed, int buffer_cap);
+  SketchPool(const SketchPool&) = delete;
+  SketchPool& operator=(const SketchPool&) = delete;
+  // Frees every sketch and buffer of the pool, those still borrowed included
+  ~SketchPool();
+
+  // Returns a zeroed sketch of length sketch_len
+  Sketch* acquire();
+  // Gives a sketch back to the pool, its contents do not need to be zeroed
+  void release(Sketch* sketch);
+  // Returns an update buffer with room for buffer_cap updates
+  vec_t* acquire_buffer();
+  void release_buffer(vec_t* buffer);
+  // Takes back every sketch and buffer at once, those still borrowed included.
+  // Whoever borrowed them must not use or release them afterwards.
+  void reset();
+
+  long get_seed() {return seed;};
+  int get_buffer_cap() {return buffer_cap;};
+  size_t num_free() {return free_sketches.size();};
+  size_t num_allocated() {return sketches.size();};
+  size_t num_buffers_in_use() {return buffers.size() - free_buffers.size();};
+};
@@ -1,55 +1,318 @@
 #pragma once
+#include <cassert>
 #include <iostream>
-#include <unordered_map>
+#include <memory>
+#include "edge_index.h"
 #include <set>
 
 #include <sketchless_skiplist.h>
+#include "component_labels.h"
 #include "types.h"
 
-class SketchlessEulerTourNode {
+template <typename Agg>
+class AggEulerTourNode : private AggregateHolder<Agg> {
+  typedef AggSkipListNode<Agg> SkipListNode;
 
-  std::unordered_map<SketchlessEulerTourNode*, SketchlessSkipListNode*> edges;
+  EdgeIndex<AggEulerTourNode, SkipListNode> edges;
 
-  SketchlessSkipListNode* allowed_caller = nullptr;
-  long seed = 0;
+  // This vertex's own value, which its allowed caller adds to the aggregates above it
+  using AggregateHolder<Agg>::agg;
+  SkipListNode* allowed_caller = nullptr;
+  AggSkipListAllocator<Agg>* allocator = nullptr;
+  uint64_t* list_epoch = nullptr;
 
-  SketchlessSkipListNode* make_edge(SketchlessEulerTourNode* other);
-  void delete_edge(SketchlessEulerTourNode* other);
+  SkipListNode* make_edge(AggEulerTourNode* other);
+  void delete_edge(AggEulerTourNode* other);
+  // Returns the occurrence that starts this vertex's tour if there is one, otherwise any occurrence
+  SkipListNode* front_occurrence();
 
 public:
   const node_id_t vertex = 0;
   const uint32_t tier = 0;
 
-  SketchlessEulerTourNode(long seed, node_id_t vertex, uint32_t tier);
-  SketchlessEulerTourNode(long seed);
-  ~SketchlessEulerTourNode();
-  bool link(SketchlessEulerTourNode& other);
-  bool cut(SketchlessEulerTourNode& other);
+  AggEulerTourNode(node_id_t vertex, uint32_t tier, AggSkipListAllocator<Agg>* allocator, uint64_t* list_epoch);
+  AggEulerTourNode(AggSkipListAllocator<Agg>* allocator, uint64_t* list_epoch);
+  bool link(AggEulerTourNode& other);
+  bool cut(AggEulerTourNode& other);
 
   bool isvalid() const;
 
-  SketchlessSkipListNode* get_root();
+  SkipListNode* get_root();
+  // Returns the sentinel that ends this vertex's tour if it has one, only one vertex per tree does
+  SkipListNode* get_sentinel() {return edges.find(nullptr);};
 
-  bool has_edge_to(SketchlessEulerTourNode* other);
+  // Returns the aggregate of this vertex's tree
+  const Agg& get_aggregate() {return allowed_caller->get_list_aggregate();};
+  // Adds delta to this vertex's value and to the aggregates above it
+  void update_aggregate(const Agg& delta);
+  bool has_edge_to(AggEulerTourNode* other);
 
-  std::set<SketchlessEulerTourNode*> get_component();
+  std::set<AggEulerTourNode*> get_component();
 
-  long get_seed() {return seed;};
+  AggSkipListAllocator<Agg>* get_allocator() {return allocator;};
+  uint64_t* get_list_epoch() {return list_epoch;};
 
-  friend std::ostream& operator<<(std::ostream& os, const SketchlessEulerTourNode& ett);
+  template <typename A>
+  friend std::ostream& operator<<(std::ostream& os, const AggEulerTourNode<A>& ett);
 };
 
-class SketchlessEulerTourTree {
-  long seed = 0;
+// Euler tour tree without sketches, whose skiplists keep the aggregate given by
+// the Agg policy (see sketchless_skiplist.h)
+template <typename Agg>
+class AggEulerTourTree {
+  // Owns the memory of every skiplist node in this tree
+  std::unique_ptr<AggSkipListAllocator<Agg>> allocator;
+  // Counts the joins and splits of this tree's skiplists, which invalidate cached roots
+  std::unique_ptr<uint64_t> list_epoch;
+
+  // Destroys the skiplist of every tree one node at a time
+  void free_lists();
 public:
-  std::vector<SketchlessEulerTourNode> ett_nodes;
-
-  SketchlessEulerTourTree(node_id_t num_nodes, uint32_t tier_num, int seed);
-  
-  void link(node_id_t u, node_id_t v);
-  void cut(node_id_t u, node_id_t v);
-  bool has_edge(node_id_t u, node_id_t v);
-  SketchlessSkipListNode* get_root(node_id_t u);
-  bool is_connected(node_id_t u, node_id_t v);
+  std::vector<AggEulerTourNode<Agg>> ett_nodes;
+
+  AggEulerTourTree(node_id_t num_nodes, uint32_t tier_num);
+  AggEulerTourTree(AggEulerTourTree&&) = default;
+  ~AggEulerTourTree();
+
+  void link(node_id_t u, node_id_t v) {ett_nodes[u].link(ett_nodes[v]);};
+  void cut(node_id_t u, node_id_t v) {ett_nodes[u].cut(ett_nodes[v]);};
+  bool has_edge(node_id_t u, node_id_t v) {return ett_nodes[u].has_edge_to(&ett_nodes[v]);};
+  AggSkipListNode<Agg>* get_root(node_id_t u) {return ett_nodes[u].get_root();};
+  bool is_connected(node_id_t u, node_id_t v) {return get_root(u) == get_root(v);};
+  const Agg& get_aggregate(node_id_t u) {return ett_nodes[u].get_aggregate();};
+  void update_aggregate(node_id_t u, const Agg& delta) {ett_nodes[u].update_aggregate(delta);};
   std::vector<std::set<node_id_t>> cc_query();
+  // Labels every vertex with its tree, and groups the vertices by tree if with_lists is set
+  void cc_query(ComponentLabels& cc, bool with_lists = false);
 };
+
+typedef AggEulerTourNode<NoAggregate> SketchlessEulerTourNode;
+typedef AggEulerTourTree<NoAggregate> SketchlessEulerTourTree;
+
+template <typename Agg>
+AggEulerTourTree<Agg>::AggEulerTourTree(node_id_t num_nodes, uint32_t tier_num) :
+    allocator(new AggSkipListAllocator<Agg>()), list_epoch(new uint64_t(1)) {
+  // Initialize all the ETT node
+  ett_nodes.reserve(num_nodes);
+  for (node_id_t i = 0; i < num_nodes; ++i) {
+      ett_nodes.emplace_back(i, tier_num, allocator.get(), list_epoch.get());
+  }
+}
+
+template <typename Agg>
+AggEulerTourTree<Agg>::~AggEulerTourTree() {
+  // Slab memory is freed in bulk by the allocator
+  if (allocator && allocator->uses_heap())
+    free_lists();
+}
+
+template <typename Agg>
+void AggEulerTourTree<Agg>::free_lists() {
+  // Each tree is freed through the one sentinel it has
+  for (AggEulerTourNode<Agg>& node : ett_nodes) {
+    if (AggSkipListNode<Agg>* sentinel = node.get_sentinel())
+      sentinel->uninit_list();
+  }
+}
+
+template <typename Agg>
+AggEulerTourNode<Agg>::AggEulerTourNode(node_id_t vertex, uint32_t tier, AggSkipListAllocator<Agg>* allocator, uint64_t* list_epoch) :
+    AggregateHolder<Agg>(Agg::of_vertex(vertex)), allocator(allocator), list_epoch(list_epoch), vertex(vertex), tier(tier) {
+  // Initialize sentinel
+  this->make_edge(nullptr);
+}
+
+template <typename Agg>
+AggEulerTourNode<Agg>::AggEulerTourNode(AggSkipListAllocator<Agg>* allocator, uint64_t* list_epoch) :
+    AggregateHolder<Agg>(Agg::of_vertex(0)), allocator(allocator), list_epoch(list_epoch) {
+  // Initialize sentinel
+  this->make_edge(nullptr);
+}
+
+template <typename Agg>
+AggSkipListNode<Agg>* AggEulerTourNode<Agg>::make_edge(AggEulerTourNode* other) {
+  assert(!other || this->tier == other->tier);
+  //Constructing a new SkipListNode with pointer to this ETT object
+  SkipListNode* node = SkipListNode::init_element(this);
+  //Add the new SkipListNode to the edge list
+  node = this->edges.insert(other, node);
+  if (allowed_caller == nullptr) {
+    allowed_caller = node;
+    allowed_caller->add_path_agg(agg());
+  }
+  return node;
+  //Returns the new node pointer or the one that already existed if it did
+}
+
+template <typename Agg>
+void AggEulerTourNode<Agg>::delete_edge(AggEulerTourNode* other) {
+  assert(!other || this->tier == other->tier);
+  SkipListNode* node_to_delete = this->edges.find(other);
+  this->edges.erase(other);
+  // An occurrence that is not alone in its list is cut straight out of it
+  bool alone = !node_to_delete->prev() && !node_to_delete->next();
+  if (!alone)
+    SkipListNode::excise(node_to_delete);
+  if (node_to_delete == allowed_caller) {
+    if (this->edges.empty()) {
+      // The value waits in this node for the next occurrence
+      allowed_caller = nullptr;
+    } else {
+      allowed_caller = this->edges.any();
+      allowed_caller->add_path_agg(agg());
+    }
+  }
+  node_to_delete->uninit_element(alone);
+}
+
+template <typename Agg>
+AggSkipListNode<Agg>* AggEulerTourNode<Agg>::front_occurrence() {
+  SkipListNode* first = this->allowed_caller->get_first()->next();
+  return first->node == this ? first : this->edges.any();
+}
+
+template <typename Agg>
+AggSkipListNode<Agg>* AggEulerTourNode<Agg>::get_root() {
+  return this->allowed_caller->get_root();
+}
+
+template <typename Agg>
+void AggEulerTourNode<Agg>::update_aggregate(const Agg& delta) {
+  agg().add(delta);
+  allowed_caller->add_path_agg(delta);
+}
+
+template <typename Agg>
+bool AggEulerTourNode<Agg>::has_edge_to(AggEulerTourNode* other) {
+  return this->edges.find(other) != nullptr;
+}
+
+template <typename Agg>
+std::set<AggEulerTourNode<Agg>*> AggEulerTourNode<Agg>::get_component() {
+  return this->allowed_caller->get_component();
+}
+
+template <typename Agg>
+bool AggEulerTourNode<Agg>::link(AggEulerTourNode& other) {
+  assert(this->tier == other.tier);
+  SkipListNode* this_sentinel = this->edges.any()->get_last();
+  SkipListNode* other_sentinel = other.edges.any()->get_last();
+
+  // There should always be a sentinel
+  assert(this_sentinel == this_sentinel->node->edges.find(nullptr));
+  assert(other_sentinel == other_sentinel->node->edges.find(nullptr));
+
+  // If the nodes are already part of the same tree, don't link
+  if (this_sentinel == other_sentinel) {
+    return false;
+  }
+
+  // linking BD, ABA with CDEDC
+  // ABA split on B gives A BA
+  // CDEDC removing sentinel gives CDED
+  //                               ^ might be null
+  // CDED split on D gives C DED
+  // A, construct B, DED, C, construct D, BA
+  // ^                    ^
+  // '--------------------'--- might be null
+  // Splitting at an occurrence that already starts its tour is free, so prefer those
+
+  SkipListNode* aux_this_right = this->front_occurrence();
+  SkipListNode* aux_this_left = SkipListNode::split_left(aux_this_right);
+
+  // Cut other_sentinel out of its tour and destroy it
+  bool other_is_sentinel_only = !other_sentinel->prev();
+  other_sentinel->node->delete_edge(nullptr);
+
+  SkipListNode* aux_other_left, *aux_other_right;
+  if (other_is_sentinel_only) {
+    aux_other_right = aux_other_left = nullptr;
+  } else {
+    aux_other_right = other.front_occurrence();
+    aux_other_left = SkipListNode::split_left(aux_other_right);
+  }
+
+  // reroot other tree
+  // A, construct B, DED, C, construct D, BA
+  // R  LR           L    R  LR           L
+  // N                    N
+
+  SkipListNode* aux_edge_left = this->make_edge(&other);
+  SkipListNode* aux_edge_right = other.make_edge(this);
+
+  SkipListNode::join(aux_this_left, aux_edge_left, aux_other_right,
+      aux_other_left, aux_edge_right, aux_this_right);
+
+  return true;
+}
+
+template <typename Agg>
+bool AggEulerTourNode<Agg>::cut(AggEulerTourNode& other) {
+  assert(this->tier == other.tier);
+  if (!this->edges.find(&other)) {
+    assert(!other.edges.find(this));
+    return false;
+  }
+  SkipListNode* e1 = this->edges.find(&other);
+  SkipListNode* e2 = other.edges.find(this);
+
+  // The tour is L e M e' R for the two occurrences e and e' in order, where L and M
+  // might be null. Split M out, cut e and e' out of their lists, then join L with R
+  // and M with a new sentinel for the vertex on its side.
+  SkipListNode* e1_left = e1->prev();
+  SkipListNode* e1_right = e1->next();
+  SkipListNode* e2_left = e2->prev();
+  SkipListNode* e2_right = e2->next();
+
+  SkipListNode::split_right(e1);
+  bool order_is_e1e2 = e2->get_last() != e1;
+  SkipListNode* frag_l, *frag_m, *frag_r;
+  if (order_is_e1e2) {
+    frag_l = e1_left;
+    frag_m = e1_right != e2 ? e1_right : nullptr;
+    frag_r = e2_right;
+    SkipListNode::split_left(e2);
+  } else {
+    frag_l = e2_left;
+    frag_m = e2_right != e1 ? e2_right : nullptr;
+    frag_r = e1_right;
+    if (frag_m) SkipListNode::split_right(e2);
+  }
+  this->delete_edge(&other);
+  other.delete_edge(this);
+
+  // The vertex whose subtree was M becomes the root of its new tree
+  AggEulerTourNode& m_vertex = order_is_e1e2 ? other : *this;
+  SkipListNode* sentinel = m_vertex.make_edge(nullptr);
+  SkipListNode::join(frag_m, sentinel);
+  SkipListNode::join(frag_l, frag_r);
+
+  return true;
+}
+
+template <typename Agg>
+std::vector<std::set<node_id_t>> AggEulerTourTree<Agg>::cc_query() {
+  ComponentLabels cc;
+  cc_query(cc);
+  return cc.to_sets();
+}
+
+template <typename Agg>
+void AggEulerTourTree<Agg>::cc_query(ComponentLabels& cc, bool with_lists) {
+  // Each tour ends in the sentinel of exactly one of its vertices
+  std::vector<AggSkipListNode<Agg>*> sentinels;
+  for (AggEulerTourNode<Agg>& node : ett_nodes) {
+    if (AggSkipListNode<Agg>* sentinel = node.get_sentinel())
+      sentinels.push_back(sentinel);
+  }
+  cc.labels.resize(ett_nodes.size());
+  cc.num_components = sentinels.size();
+  // Label the trees in parallel, each with one scan of the bottom level of its skiplist
+  #pragma omp parallel for schedule(dynamic, 64)
+  for (node_id_t c = 0; c < cc.num_components; c++) {
+    for (AggSkipListNode<Agg>* curr = sentinels[c]->get_first()->next(); curr; curr = curr->next())
+      cc.labels[curr->node->vertex] = c;
+  }
+  if (with_lists)
+    cc.build_lists();
+}
@@ -1,56 +1,460 @@
 #pragma once
 
+#include <cassert>
+#include <cstdint>
 #include <set>
+#include <type_traits>
+#include <xxhash.h>
+#include "slab_allocator.h"
+#include "types.h"
 
-class SketchlessEulerTourNode;
+template <typename Agg> class AggEulerTourNode;
+template <typename Agg> class AggSkipListNode;
+
+template <typename Agg>
+using AggSkipListAllocator = SlabAllocator<AggSkipListNode<Agg>>;
 
 extern long sketchless_skiplist_seed;
 extern double sketchless_height_factor;
 
-class SketchlessSkipListNode {
+// Aggregate policies for AggSkipListNode. A policy is the value of a range of the
+// list, default constructed to the value of an empty range. Every vertex adds
+// of_vertex(vertex) to the range it is in, and add and subtract have to form an
+// abelian group so joins and splits fix aggregates up without rescanning levels.
+// Empty policies are not stored at all and skip every aggregate update.
+
+// Keeps no aggregate, for trees that only answer connectivity
+struct NoAggregate {
+  static NoAggregate of_vertex(node_id_t) { return {}; }
+  void add(const NoAggregate&) {}
+  void subtract(const NoAggregate&) {}
+};
+
+// Counts the vertices of each tree
+struct SizeAggregate {
+  uint32_t size = 0;
+  static SizeAggregate of_vertex(node_id_t) { return {1}; }
+  void add(const SizeAggregate& other) { size += other.size; }
+  void subtract(const SizeAggregate& other) { size -= other.size; }
+};
+
+// Holds an aggregate for the classes that keep one. Empty policies are held as an
+// empty base so they take up no space in the nodes that inherit this.
+template <typename Agg, bool = std::is_empty<Agg>::value>
+class AggregateHolder {
+  Agg value;
+public:
+  AggregateHolder() = default;
+  AggregateHolder(const Agg& value) : value(value) {}
+  Agg& agg() { return value; }
+  const Agg& agg() const { return value; }
+};
+
+template <typename Agg>
+class AggregateHolder<Agg, true> : private Agg {
+public:
+  AggregateHolder() = default;
+  AggregateHolder(const Agg&) {}
+  Agg& agg() { return *this; }
+  const Agg& agg() const { return *this; }
+};
+
+// Skiplist of an Euler tour whose nodes each hold the aggregate of the range they cover.
+// A vertex's value is only held by its allowed caller, so the root holds the whole tree's.
+template <typename Agg>
+class AggSkipListNode : private AggregateHolder<Agg> {
+  static constexpr bool has_aggregate = !std::is_empty<Agg>::value;
 
-  SketchlessSkipListNode* left = nullptr;
-  SketchlessSkipListNode* right = nullptr;
-  SketchlessSkipListNode* up = nullptr;
-  SketchlessSkipListNode* down = nullptr;
+  AggSkipListNode* left = nullptr;
+  AggSkipListNode* right = nullptr;
+  AggSkipListNode* up = nullptr;
+  AggSkipListNode* down = nullptr;
   // Store the first node to the left on the next level up
-  SketchlessSkipListNode* parent = nullptr;
+  AggSkipListNode* parent = nullptr;
+
+  // Only kept up to date at roots: the bottom left boundary node and the bottom right node of the list
+  AggSkipListNode* list_first = nullptr;
+  AggSkipListNode* list_last = nullptr;
+  // Root of the list the last time it was looked up from this node, trusted while the tree's list epoch matches
+  AggSkipListNode* root_hint = nullptr;
+  uint64_t hint_epoch = 0;
 
 public:
+  using AggregateHolder<Agg>::agg;
 
-  SketchlessEulerTourNode* node;
+  AggEulerTourNode<Agg>* node;
 
-  SketchlessSkipListNode(SketchlessEulerTourNode* node);
-  static SketchlessSkipListNode* init_element(SketchlessEulerTourNode* node);
+  AggSkipListNode(AggEulerTourNode<Agg>* node) : node(node) {}
+  static AggSkipListNode* init_element(AggEulerTourNode<Agg>* node);
   void uninit_element(bool delete_bdry);
   void uninit_list();
 
+  // Adds to or subtracts from the aggregate of this node and every node above it
+  void add_path_agg(const Agg& delta);
+  void subtract_path_agg(const Agg& delta);
+
+  // Returns the number of levels in this element's tower
+  uint32_t get_height();
   // Returns the closest node on the next level up at or left of the current
-  SketchlessSkipListNode* get_parent();
+  AggSkipListNode* get_parent() { return parent; }
   // Returns the top left root node of the skiplist
-  SketchlessSkipListNode* get_root();
+  AggSkipListNode* get_root();
   // Returns the bottom left boundary node of the skiplist
-  SketchlessSkipListNode* get_first();
+  AggSkipListNode* get_first() { return this->get_root()->list_first; }
   // Returns the bottom right node of the skiplist
-  SketchlessSkipListNode* get_last();
+  AggSkipListNode* get_last() { return this->get_root()->list_last; }
+  // Returns the aggregate of the whole list
+  const Agg& get_list_aggregate() { return this->get_root()->agg(); }
 
-  std::set<SketchlessEulerTourNode*> get_component();
+  std::set<AggEulerTourNode<Agg>*> get_component();
 
   // Returns the root of a new skiplist formed by joining the lists containing left and right
-  static SketchlessSkipListNode* join(SketchlessSkipListNode* left, SketchlessSkipListNode* right);
+  static AggSkipListNode* join(AggSkipListNode* left, AggSkipListNode* right);
   template <typename... T>
-  static SketchlessSkipListNode* join(SketchlessSkipListNode* head, T*... tail);
+  static AggSkipListNode* join(AggSkipListNode* head, T*... tail);
   // Returns the root of the left list after splitting to the left of the given node
-  static SketchlessSkipListNode* split_left(SketchlessSkipListNode* node);
+  static AggSkipListNode* split_left(AggSkipListNode* node);
   // Returns the root of the right list after splitting to the right of the given node
-  static SketchlessSkipListNode* split_right(SketchlessSkipListNode* node);
+  static AggSkipListNode* split_right(AggSkipListNode* node);
+  // Removes the element from the middle of its list without freeing it, returns the root of the list.
+  // The element must not be the only one in its list.
+  static AggSkipListNode* excise(AggSkipListNode* node);
 
   bool isvalid();
-  SketchlessSkipListNode* next();
+  AggSkipListNode* next() { return this->right; }
+  // Returns the element to the left, nullptr if this is the first element
+  AggSkipListNode* prev() {
+    // The boundary node is the only one at the bottom with nothing to its left
+    return this->left && this->left->left ? this->left : nullptr;
+  }
   int print_list();
 };
 
+typedef AggSkipListNode<NoAggregate> SketchlessSkipListNode;
+typedef AggSkipListAllocator<NoAggregate> SketchlessSkipListAllocator;
+
+template <typename Agg>
 template <typename... T>
-SketchlessSkipListNode* SketchlessSkipListNode::join(SketchlessSkipListNode* head, T*... tail) {
+AggSkipListNode<Agg>* AggSkipListNode<Agg>::join(AggSkipListNode* head, T*... tail) {
   return join(head, join(tail...));
 }
+
+template <typename Agg>
+void AggSkipListNode<Agg>::uninit_element(bool delete_bdry) {
+	assert(!this->down);
+	AggSkipListAllocator<Agg>* allocator = this->node->get_allocator();
+	AggSkipListNode* bdry_curr = this->left;
+	AggSkipListNode* bdry_prev;
+	// The element's tower was allocated as one contiguous block
+	allocator->destroy_array(this, get_height());
+	if (delete_bdry) {
+		while (bdry_curr) {
+			bdry_prev = bdry_curr;
+			bdry_curr = bdry_prev->up;
+			allocator->destroy(bdry_prev);
+		}
+	}
+}
+
+template <typename Agg>
+AggSkipListNode<Agg>* AggSkipListNode<Agg>::init_element(AggEulerTourNode<Agg>* node) {
+	AggSkipListAllocator<Agg>* allocator = node->get_allocator();
+	// NOTE: WE SHOULD MAKE IT SO DIFFERENT SKIPLIST NODES FOR THE SAME ELEMENT CAN BE DIFFERENT HEIGHTS
+	// Per-occurrence heights were measured for SkipListNode and were no better, see SkipListNode::init_element
+	uint64_t element_height = sketchless_height_factor*__builtin_ctzll(XXH3_64bits_withSeed(&node->vertex, sizeof(node_id_t), sketchless_skiplist_seed))+1;
+	// All levels of the element are stored contiguously so walking up its tower stays in cache
+	AggSkipListNode* tower = allocator->create_array(element_height, node);
+	AggSkipListNode* list_node, *bdry_node, *list_prev, *bdry_prev;
+	list_node = bdry_node = list_prev = bdry_prev = nullptr;
+	// Add skiplist and boundary nodes up to the random height
+	for (uint64_t i = 0; i < element_height; i++) {
+		list_node = tower + i;
+		bdry_node = allocator->create(nullptr);
+		list_node->left = bdry_node;
+		bdry_node->right = list_node;
+		if (list_prev) {
+			list_node->down = list_prev;
+			list_prev->up = list_node;
+			list_prev->parent = list_node;
+		}
+		if (bdry_prev) {
+			bdry_node->down = bdry_prev;
+			bdry_prev->up = bdry_node;
+			bdry_prev->parent = bdry_node;
+		}
+		list_prev = list_node;
+		bdry_prev = bdry_node;
+	}
+	// Add one more boundary node at height+1
+	AggSkipListNode* root = allocator->create(nullptr);
+	root->down = bdry_prev;
+	bdry_prev->up = root;
+	bdry_prev->parent = root;
+	list_prev->parent = root;
+	root->list_first = tower[0].left;
+	root->list_last = tower;
+	return tower;
+}
+
+template <typename Agg>
+void AggSkipListNode<Agg>::add_path_agg(const Agg& delta) {
+	if constexpr (has_aggregate) {
+		for (AggSkipListNode* curr = this; curr; curr = curr->parent)
+			curr->agg().add(delta);
+	}
+}
+
+template <typename Agg>
+void AggSkipListNode<Agg>::subtract_path_agg(const Agg& delta) {
+	if constexpr (has_aggregate) {
+		for (AggSkipListNode* curr = this; curr; curr = curr->parent)
+			curr->agg().subtract(delta);
+	}
+}
+
+template <typename Agg>
+uint32_t AggSkipListNode<Agg>::get_height() {
+	uint32_t height = 1;
+	for (AggSkipListNode* curr = this->up; curr; curr = curr->up)
+		height++;
+	return height;
+}
+
+template <typename Agg>
+AggSkipListNode<Agg>* AggSkipListNode<Agg>::get_root() {
+	// Boundary nodes have no ETT node to reach the tree's epoch through, so they always walk
+	uint64_t* list_epoch = this->node ? this->node->get_list_epoch() : nullptr;
+	if (list_epoch && this->root_hint && this->hint_epoch == *list_epoch)
+		return this->root_hint;
+	AggSkipListNode* prev = nullptr;
+	AggSkipListNode* curr = this;
+	while (curr) {
+		prev = curr;
+		curr = prev->get_parent();
+	}
+	if (list_epoch) {
+		this->root_hint = prev;
+		this->hint_epoch = *list_epoch;
+	}
+	return prev;
+}
+
+template <typename Agg>
+std::set<AggEulerTourNode<Agg>*> AggSkipListNode<Agg>::get_component() {
+	std::set<AggEulerTourNode<Agg>*> nodes;
+	AggSkipListNode* curr = this->get_first()->right; //Skip over the boundary node
+	while (curr) {
+		nodes.insert(curr->node);
+		curr = curr->right;
+	}
+	return nodes;
+}
+
+template <typename Agg>
+void AggSkipListNode<Agg>::uninit_list() {
+	// The boundary tower is freed along with the first element
+	AggSkipListNode* first = this->get_first()->right;
+	AggSkipListNode* curr = first;
+	AggSkipListNode* prev;
+	while (curr) {
+		prev = curr;
+		curr = prev->right;
+		prev->uninit_element(prev == first);
+	}
+}
+
+template <typename Agg>
+AggSkipListNode<Agg>* AggSkipListNode<Agg>::join(AggSkipListNode* left, AggSkipListNode* right) {
+	assert(left || right);
+	if (!left) return right->get_root();
+	if (!right) return left->get_root();
+
+	AggSkipListNode* l_first = left->get_first();
+	AggSkipListNode* r_last = right->get_last();
+	AggSkipListNode* l_curr = left->get_last();
+	AggSkipListNode* r_curr = right->get_first(); // this is the bottom boundary node
+	AggSkipListAllocator<Agg>* allocator = l_curr->node->get_allocator();
+	// Every root hint in the tree is stale from here on
+	(*l_curr->node->get_list_epoch())++;
+	AggSkipListNode* r_first = r_curr->right;
+	AggSkipListNode* l_prev = nullptr;
+	AggSkipListNode* r_prev = nullptr;
+
+	// Go up levels. link pointers, add aggregates
+	while (l_curr && r_curr) {
+		// Fix right pointer and add agg
+		l_curr->right = r_curr->right; // skip over boundary node
+		if (r_curr->right) r_curr->right->left = l_curr; // skip over boundary node, but to the left
+		l_curr->agg().add(r_curr->agg());
+
+		if (r_prev) allocator->destroy(r_prev); // Delete old boundary nodes
+		l_prev = l_curr;
+		r_prev = r_curr;
+		l_curr = l_prev->get_parent();
+		r_curr = r_prev->up;
+	}
+
+	// If left list was taller add the root agg in right to the rest in left
+	while (l_curr) {
+		l_curr->agg().add(r_prev->agg());
+		l_prev = l_curr;
+		l_curr = l_prev->get_parent();
+	}
+
+	// If right list was taller add new boundary nodes to left list
+	if (r_curr) {
+		// Each new boundary node covers all of the left list
+		Agg l_root_agg = l_prev->agg();
+		l_root_agg.subtract(r_prev->agg());
+		while (r_curr) {
+			l_curr = allocator->create(nullptr);
+			l_curr->down = l_prev;
+			l_prev->up = l_curr;
+			l_prev->parent = l_curr;
+			l_curr->right = r_curr->right;
+			if (r_curr->right) r_curr->right->left = l_curr;
+			l_curr->agg() = l_root_agg;
+			l_curr->agg().add(r_curr->agg());
+
+			if (r_prev) allocator->destroy(r_prev); // Delete old boundary nodes
+			l_prev = l_curr;
+			r_prev = r_curr;
+			r_curr = r_prev->up;
+		}
+	}
+	allocator->destroy(r_prev);
+	// Update parent pointers in right list
+	while (r_first) {
+		while (r_first && !r_first->up) {
+			r_first->parent = r_first->left->parent;
+			r_first = r_first->right;
+		}
+		if (r_first)
+			r_first = r_first->up;
+	}
+	l_prev->list_first = l_first;
+	l_prev->list_last = r_last;
+	// Returns the root of the joined list
+	return l_prev;
+}
+
+template <typename Agg>
+AggSkipListNode<Agg>* AggSkipListNode<Agg>::split_left(AggSkipListNode* node) {
+	assert(node && node->left && !node->down);
+	// If just splitting off the boundary nodes do nothing instead
+	if (!node->left->left) {
+		return nullptr;
+	}
+	AggSkipListAllocator<Agg>* allocator = node->node->get_allocator();
+	AggSkipListNode* old_root = node->get_root();
+	AggSkipListNode* l_first = old_root->list_first;
+	AggSkipListNode* l_last = node->left;
+	AggSkipListNode* r_last = old_root->list_last;
+	// Every root hint in the tree is stale from here on
+	(*node->node->get_list_epoch())++;
+	// Construct new boundary nodes with correct aggregates for the right component
+	// New aggs will be sum of all aggs on each level in the right path
+	// Subtract those new aggregates from the "corners" of the left path
+	// And unlink the nodes and link with the  new boundary nodes
+	AggSkipListNode* r_curr = node;
+	AggSkipListNode* l_curr = node->left;
+	AggSkipListNode* bdry = allocator->create(nullptr);
+	AggSkipListNode* r_first_bdry = bdry;
+	AggSkipListNode* new_bdry;
+	while (r_curr) {
+		r_curr->left = bdry;
+		bdry->right = r_curr;
+		l_curr->right = nullptr;
+		l_curr->agg().subtract(bdry->agg());
+		// Get next l_curr, r_curr, and bdry
+		l_curr = l_curr->get_parent();
+		new_bdry = allocator->create(nullptr);
+		new_bdry->agg() = bdry->agg();
+		while (r_curr && !r_curr->up) {
+			new_bdry->agg().add(r_curr->agg());
+			r_curr->parent = new_bdry;
+			r_curr = r_curr->right;
+		}
+		r_curr = r_curr ? r_curr->up : nullptr;
+		new_bdry->down = bdry;
+		bdry->up = new_bdry;
+		bdry->parent = new_bdry;
+		bdry = new_bdry;
+	}
+	bdry->list_first = r_first_bdry;
+	bdry->list_last = r_last;
+	// Subtract the final right agg from the rest of the aggs on left path
+	AggSkipListNode* l_prev = nullptr;
+	while (l_curr) {
+		l_curr->agg().subtract(bdry->agg());
+		l_prev  = l_curr;
+		l_curr = l_curr->get_parent();
+	}
+	// Trim extra boundary nodes on the left list
+	l_curr = l_prev->down;
+	while (!l_curr->right) {
+		allocator->destroy(l_prev);
+		l_prev = l_curr;
+		l_curr = l_prev->down;
+	}
+	l_prev->up = nullptr;
+	l_prev->parent = nullptr;
+	l_prev->list_first = l_first;
+	l_prev->list_last = l_last;
+	// Returns the root of left list
+	return l_prev;
+}
+
+template <typename Agg>
+AggSkipListNode<Agg>* AggSkipListNode<Agg>::excise(AggSkipListNode* node) {
+	assert(node && node->left && !node->down);
+	// The list has to keep at least one element
+	assert(node->left->left || node->right);
+	AggSkipListAllocator<Agg>* allocator = node->node->get_allocator();
+	AggSkipListNode* root = node->get_root();
+	AggSkipListNode* list_first = root->list_first;
+	AggSkipListNode* list_last = root->list_last == node ? node->left : root->list_last;
+	// Every root hint in the tree is stale from here on
+	(*node->node->get_list_epoch())++;
+	// Unlink each level of the tower. The left neighbor takes over the rest of the
+	// tower node's children, so it gains the tower node's aggregate minus the element.
+	AggSkipListNode* curr = node;
+	AggSkipListNode* top = node;
+	while (curr) {
+		AggSkipListNode* left = curr->left;
+		left->right = curr->right;
+		if (curr->right) curr->right->left = left;
+		if (curr->down) {
+			for (AggSkipListNode* child = curr->down->right; child && !child->up; child = child->right)
+				child->parent = left;
+			left->agg().add(curr->agg());
+			left->agg().subtract(node->agg());
+		}
+		top = curr;
+		curr = curr->up;
+	}
+	// Above the tower the element just leaves every aggregate on its path
+	if (top->parent)
+		top->parent->subtract_path_agg(node->agg());
+	// Trim boundary nodes left without anything to their right
+	curr = root->down;
+	while (!curr->right) {
+		allocator->destroy(root);
+		root = curr;
+		curr = root->down;
+	}
+	root->up = nullptr;
+	root->parent = nullptr;
+	root->list_first = list_first;
+	root->list_last = list_last;
+	return root;
+}
+
+template <typename Agg>
+AggSkipListNode<Agg>* AggSkipListNode<Agg>::split_right(AggSkipListNode* node) {
+	assert(node);
+	AggSkipListNode* right = node->right;
+	if (!right) return nullptr;
+	AggSkipListNode::split_left(right);
+	return right->get_root();
+}
@@ -2,16 +2,27 @@
 
 #include <gtest/gtest.h>
 #include "sketch.h"
+#include "sketch_pool.h"
+#include "slab_allocator.h"
 
 class EulerTourNode;
+class SkipListNode;
 
+typedef SlabAllocator<SkipListNode> SkipListAllocator;
+
+// Default number of sketch updates buffered at a skiplist node before applying them
 constexpr int skiplist_buffer_cap = 25;
+// Most edge ids an aggregate keeps exactly in its update buffer before it allocates a sketch.
+// Past this, adding an exact aggregate to a sketch costs more than merging two sketches.
+constexpr int exact_agg_cap = 8;
 extern long skiplist_seed;
 extern double height_factor;
 extern vec_t sketch_len;
 extern vec_t sketch_err;
 
 class SkipListNode {
+  FRIEND_TEST(SkipListSuite, excise_test);
+  FRIEND_TEST(EulerTourTreeSuite, sample_cache_test);
 
   SkipListNode* left = nullptr;
   SkipListNode* right = nullptr;
@@ -20,23 +31,50 @@ class SkipListNode {
   // Store the first node to the left on the next level up
   SkipListNode* parent = nullptr;
 
-  vec_t update_buffer[skiplist_buffer_cap];
+  // Only kept up to date at roots: the bottom left boundary node and the bottom right node of the list
+  SkipListNode* list_first = nullptr;
+  SkipListNode* list_last = nullptr;
+  // Root of the list the last time it was looked up from this node. Only trusted while
+  // no list of the tree has been joined or split since, which the tree's list epoch tracks.
+  SkipListNode* root_hint = nullptr;
+  uint64_t hint_epoch = 0;
+
+  // Edge ids added to the aggregate but not to its sketch, borrowed from the sketch pool
+  // while there are any. Every id is in the buffer at most once, adding it again cancels it.
+  // Without a sketch the buffer is the exact aggregate, which keeps small components
+  // from paying for a sketch until their buffer fills up.
+  vec_t* update_buffer = nullptr;
   int buffer_size = 0;
-  int buffer_capacity;
+
+  // Pool the aggregate sketch is borrowed from and returned to
+  SketchPool* sketch_pool;
+  // Whether this node keeps an aggregate at all. The sketch itself is only
+  // allocated once the aggregate no longer fits in the update buffer.
+  bool has_sketch;
+  // Last sample of the aggregate sketch, only valid until the aggregate changes
+  SketchSample cached_sample;
+  bool sample_dirty = true;
+
+  // Goes back to an exact aggregate if the children's exact aggregates fit in the buffer
+  void try_demote();
 
 public:
+  // Aggregate sketch of this node, nullptr stands for the zero vector.
+  // The aggregate is this sketch plus the edge ids in the update buffer.
   Sketch* sketch_agg = nullptr;
 
   uint32_t size = 1;
 
   EulerTourNode* node;
 
-  SkipListNode(EulerTourNode* node, long seed, bool has_sketch);
+  SkipListNode(EulerTourNode* node, SketchPool* sketch_pool, bool has_sketch);
   ~SkipListNode();
   static SkipListNode* init_element(EulerTourNode* node, bool is_allowed_caller);
   void uninit_element(bool delete_bdry);
   void uninit_list();
 
+  // Returns the number of levels in this element's tower
+  uint32_t get_height();
   // Returns the closest node on the next level up at or left of the current
   SkipListNode* get_parent();
   // Returns the top left root node of the skiplist
@@ -48,17 +86,29 @@ public:
 
   // Return the aggregate size at the root of the list
   uint32_t get_list_size();
-  // Return the aggregate sketch at the root of the list
+  // Return the aggregate sketch at the root of the list, with all of the aggregate moved into it
   Sketch* get_list_aggregate();
   // Update all the aggregate sketches with the input vector from the current node to its root
   SkipListNode* update_path_agg(vec_t update_idx);
-  // Add the given sketch to all aggregate sketches from the current node to its root
-  SkipListNode* update_path_agg(Sketch* sketch);
+  // Move the aggregate of other into the current node, which must have none, and add it to
+  // all aggregates from the current node to its root. Other is left with the zero aggregate.
+  SkipListNode* update_path_agg(SkipListNode* other);
 
-  // Update just this node's aggregate sketch
+  // Update just this node's aggregate, buffering the update
   void update_agg(vec_t update_idx);
-
-  // Apply all the sketch updates currently in the update buffer
+  // Add the given sketch to just this node's aggregate sketch, nullptr is the zero vector
+  void merge_agg(Sketch* sketch);
+  // Add the aggregate of other to just this node's aggregate, keeping it exact if it fits
+  void merge_agg(SkipListNode* other);
+  // Return this node's aggregate sketch, allocating it if it is still the zero vector.
+  // The sketch may be changed through the pointer, so the cached sample is dropped.
+  Sketch* get_sketch();
+  // Sample this node's aggregate, an exact aggregate gives any of its edge ids. The sample
+  // is cached until the aggregate changes, so sampling an unchanged root is free.
+  SketchSample sample_agg();
+
+  // Apply all the sketch updates currently in the update buffer, after which the
+  // whole aggregate is in the sketch
   void process_updates();
 
   std::set<EulerTourNode*> get_component();
@@ -71,9 +121,14 @@ public:
   static SkipListNode* split_left(SkipListNode* node);
   // Returns the root of the right list after splitting to the right of the given node
   static SkipListNode* split_right(SkipListNode* node);
+  // Removes the element from the middle of its list without freeing it, returns the root of the list.
+  // The element must not be the only one in its list.
+  static SkipListNode* excise(SkipListNode* node);
 
   bool isvalid();
   SkipListNode* next();
+  // Returns the element to the left, nullptr if this is the first element
+  SkipListNode* prev();
   int print_list();
 };
 
@@ -0,0 +1,124 @@
+#pragma once
+#include <cassert>
+#include <cstddef>
+#include <new>
+#include <utility>
+#include <vector>
+
+// When false new allocators fall back to the global heap (new/delete)
+extern bool use_slab_allocator;
+
+// Allocates objects of a single type out of large slabs of memory.
+// Destroyed objects are put on a free list and reused by later allocations,
+// and all of the slabs are released at once when the allocator is destroyed.
+// Objects can also be allocated as contiguous arrays, which are kept on
+// separate free lists by length so they are reused without fragmenting.
+// Not thread safe, each EulerTourTree owns its own allocator.
+template <typename T>
+class SlabAllocator {
+  struct FreeNode {
+    FreeNode* next;
+  };
+  static_assert(sizeof(T) >= sizeof(FreeNode), "Objects too small to hold a free list pointer");
+
+  static constexpr size_t objects_per_slab = 4096;
+
+  std::vector<T*> slabs;
+  // Slabs handed out from so far, the rest are kept for reuse after a reset
+  size_t slabs_used = 0;
+  // Free lists of contiguous runs, indexed by the number of objects in the run
+  std::vector<FreeNode*> free_lists;
+  // Next unused object in the current slab
+  size_t slab_offset = objects_per_slab;
+
+  const bool use_heap;
+
+  void release(T* ptr, size_t count) {
+    if (count >= free_lists.size())
+      free_lists.resize(count+1, nullptr);
+    FreeNode* node = reinterpret_cast<FreeNode*>(ptr);
+    node->next = free_lists[count];
+    free_lists[count] = node;
+  }
+
+  T* allocate(size_t count) {
+    assert(count > 0 && count <= objects_per_slab);
+    if (count < free_lists.size() && free_lists[count]) {
+      T* ptr = reinterpret_cast<T*>(free_lists[count]);
+      free_lists[count] = free_lists[count]->next;
+      return ptr;
+    }
+    if (slab_offset + count > objects_per_slab) {
+      // Hand out what is left of the current slab as single objects
+      while (slab_offset < objects_per_slab)
+        release(slabs[slabs_used-1] + slab_offset++, 1);
+      if (slabs_used == slabs.size())
+        slabs.push_back(static_cast<T*>(::operator new(sizeof(T)*objects_per_slab)));
+      slabs_used++;
+      slab_offset = 0;
+    }
+    T* ptr = slabs[slabs_used-1] + slab_offset;
+    slab_offset += count;
+    return ptr;
+  }
+
+public:
+  SlabAllocator() : use_heap(!use_slab_allocator) {}
+  SlabAllocator(const SlabAllocator&) = delete;
+  SlabAllocator& operator=(const SlabAllocator&) = delete;
+  // Releases all slab memory. Objects still alive are not destructed.
+  ~SlabAllocator() {
+    for (T* slab : slabs)
+      ::operator delete(slab);
+  }
+
+  template <typename... Args>
+  T* create(Args&&... args) {
+    if (use_heap)
+      return new T(std::forward<Args>(args)...);
+    return new (allocate(1)) T(std::forward<Args>(args)...);
+  }
+
+  void destroy(T* ptr) {
+    if (use_heap) {
+      delete ptr;
+      return;
+    }
+    ptr->~T();
+    release(ptr, 1);
+  }
+
+  // Constructs count contiguous objects from the same arguments
+  template <typename... Args>
+  T* create_array(size_t count, const Args&... args) {
+    T* ptr = use_heap ? static_cast<T*>(::operator new(sizeof(T)*count)) : allocate(count);
+    for (size_t i = 0; i < count; i++)
+      new (ptr+i) T(args...);
+    return ptr;
+  }
+
+  // Destroys an array from create_array, count must match the one it was created with
+  void destroy_array(T* ptr, size_t count) {
+    for (size_t i = 0; i < count; i++)
+      ptr[i].~T();
+    if (use_heap)
+      ::operator delete(ptr);
+    else
+      release(ptr, count);
+  }
+
+  // Forgets every object at once without destructing them, their slabs are
+  // handed out again from the start. Has no effect when falling back to the heap.
+  void reset() {
+    if (use_heap)
+      return;
+    free_lists.clear();
+    slabs_used = 0;
+    slab_offset = objects_per_slab;
+  }
+
+  bool uses_heap() const { return use_heap; }
+
+  // Total bytes of slab memory reserved by this allocator
+  size_t reserved_bytes() const { return slabs.size()*objects_per_slab*sizeof(T); }
+};
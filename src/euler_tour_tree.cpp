@@ -1,23 +1,88 @@
+#include <algorithm>
 #include <cassert>
 
 #include <euler_tour_tree.h>
+#include "util.h"
 
-EulerTourTree::EulerTourTree(node_id_t num_nodes, uint32_t tier_num, int seed) {
+// Past this many pending updates a node's updates are folded into one delta sketch, so every
+// level above it costs a single merge instead of one sketch update per update
+constexpr size_t batch_fold_threshold = 8;
+
+EulerTourNodeArray::EulerTourNodeArray(EulerTourNodeArray&& other) noexcept :
+    nodes(other.nodes), num_nodes(other.num_nodes), capacity(other.capacity), stride(other.stride), owns_storage(other.owns_storage) {
+  other.nodes = nullptr;
+  other.num_nodes = other.capacity = 0;
+  other.owns_storage = false;
+}
+
+EulerTourNodeArray::~EulerTourNodeArray() {
+  for (node_id_t i = num_nodes; i-- > 0;)
+    (*this)[i].~EulerTourNode();
+  if (owns_storage)
+    deallocate(nodes, capacity);
+}
+
+void EulerTourNodeArray::reserve(node_id_t num_nodes) {
+  assert(!nodes);
+  nodes = allocate(num_nodes);
+  capacity = num_nodes;
+  stride = 1;
+  owns_storage = true;
+}
+
+void EulerTourNodeArray::place(EulerTourNode* storage, node_id_t num_nodes, uint32_t stride) {
+  assert(!nodes);
+  nodes = storage;
+  capacity = num_nodes;
+  this->stride = stride;
+  owns_storage = false;
+}
+
+EulerTourTree::EulerTourTree(node_id_t num_nodes, uint32_t tier_num, int seed, int buffer_cap, EulerTourNode* node_storage, uint32_t node_stride) :
+    allocator(new SkipListAllocator()), sketch_pool(new SketchPool(seed, buffer_cap)), list_epoch(new uint64_t(1)) {
   // Initialize all the ETT node
-    ett_nodes.reserve(num_nodes);
+    if (node_storage)
+      ett_nodes.place(node_storage, num_nodes, node_stride);
+    else
+      ett_nodes.reserve(num_nodes);
     for (node_id_t i = 0; i < num_nodes; ++i) {
-        ett_nodes.emplace_back(seed, i, tier_num);
+        ett_nodes.emplace_back(i, tier_num, allocator.get(), sketch_pool.get(), list_epoch.get());
     }
-    // Initialize the temp_sketch
-    this->temp_sketch = new Sketch(sketch_len, seed, 1, sketch_err);
+    // Initialize the temp_agg
+    this->temp_agg.reset(new SkipListNode(nullptr, sketch_pool.get(), true));
+}
+
+EulerTourTree::~EulerTourTree() {
+  // Slab memory and pooled sketches are freed in bulk by their owners
+  if (allocator && allocator->uses_heap())
+    free_lists();
+}
+
+void EulerTourTree::free_lists() {
+  // Each tree is freed through the one sentinel it has
+  for (EulerTourNode& node : ett_nodes) {
+    if (SkipListNode* sentinel = node.get_sentinel())
+      sentinel->uninit_list();
+  }
+}
+
+void EulerTourTree::reset() {
+  if (allocator->uses_heap())
+    free_lists();
+  else
+    allocator->reset();
+  sketch_pool->reset();
+  (*list_epoch)++;
+  for (EulerTourNode& node : ett_nodes)
+    node.reset();
 }
 
 void EulerTourTree::link(node_id_t u, node_id_t v) {
-  ett_nodes[u].link(ett_nodes[v], temp_sketch);
+  ett_nodes[u].link(ett_nodes[v], temp_agg.get());
 }
 
 void EulerTourTree::cut(node_id_t u, node_id_t v) {
-  ett_nodes[u].cut(ett_nodes[v], temp_sketch);
+  ett_nodes[u].cut(ett_nodes[v], temp_agg.get());
 }
 
 bool EulerTourTree::has_edge(node_id_t u, node_id_t v) {
@@ -52,6 +117,85 @@ std::pair<SkipListNode*, SkipListNode*> EulerTourTree::update_sketches(node_id_t
 	return {prev1, prev2};
 }
 
+void EulerTourTree::update_sketches_batch(const GraphUpdate* updates, uint32_t num_updates, BatchRoot* roots) {
+  auto update_idx = [updates](uint32_t i) {
+    return (vec_t)VERTICES_TO_EDGE(updates[i].edge.src, updates[i].edge.dst);
+  };
+  // The roots are updated in order so each update sees the aggregates as they are right after it
+  batch_updates.clear();
+  batch_deltas.clear();
+  for (uint32_t i = 0; i < num_updates; i++) {
+    SkipListNode* leaf1 = ett_nodes[updates[i].edge.src].allowed_caller;
+    SkipListNode* leaf2 = ett_nodes[updates[i].edge.dst].allowed_caller;
+    SkipListNode* root1 = leaf1->get_root();
+    SkipListNode* root2 = leaf2->get_root();
+    // Both paths cancel out above their first common node
+    if (root1 != root2) {
+      root1->update_agg(update_idx(i));
+      root2->update_agg(update_idx(i));
+    }
+    roots[2*i] = {root1, root1->size, root1->sample_agg().result};
+    roots[2*i+1] = {root2, root2->size, root2->sample_agg().result};
+    batch_updates.push_back({leaf1, i});
+    batch_updates.push_back({leaf2, i});
+  }
+  // Apply the rest of the updates bottom up, one skiplist level at a time. Sorting a level
+  // groups the updates and delta sketches of each node, which then go on to its parent.
+  while (!batch_updates.empty() || !batch_deltas.empty()) {
+    std::sort(batch_updates.begin(), batch_updates.end());
+    std::sort(batch_deltas.begin(), batch_deltas.end());
+    next_batch_updates.clear();
+    next_batch_deltas.clear();
+    size_t u = 0, d = 0;
+    while (u < batch_updates.size() || d < batch_deltas.size()) {
+      SkipListNode* node;
+      if (d == batch_deltas.size() || (u < batch_updates.size() && batch_updates[u].first < batch_deltas[d].first))
+        node = batch_updates[u].first;
+      else
+        node = batch_deltas[d].first;
+      // An update that reaches a node from both of its endpoints cancels out
+      size_t begin = u, end = u;
+      for (; u < batch_updates.size() && batch_updates[u].first == node; u++) {
+        if (u+1 < batch_updates.size() && batch_updates[u+1] == batch_updates[u])
+          u++;
+        else
+          batch_updates[end++] = batch_updates[u];
+      }
+      Sketch* delta = nullptr;
+      for (; d < batch_deltas.size() && batch_deltas[d].first == node; d++) {
+        if (!delta) {
+          delta = batch_deltas[d].second;
+        } else {
+          delta->merge(*batch_deltas[d].second);
+          sketch_pool->release(batch_deltas[d].second);
+        }
+      }
+      SkipListNode* parent = node->get_parent();
+      if (!parent) { // Roots were already updated
+        if (delta) sketch_pool->release(delta);
+        continue;
+      }
+      // Exact aggregates take the updates one by one instead of being turned into sketches
+      if (end-begin > batch_fold_threshold && node->sketch_agg) {
+        if (!delta) delta = sketch_pool->acquire();
+        for (size_t i = begin; i < end; i++)
+          delta->update(update_idx(batch_updates[i].second));
+        end = begin;
+      }
+      for (size_t i = begin; i < end; i++) {
+        node->update_agg(update_idx(batch_updates[i].second));
+        next_batch_updates.push_back({parent, batch_updates[i].second});
+      }
+      if (delta) {
+        node->merge_agg(delta);
+        next_batch_deltas.push_back({parent, delta});
+      }
+    }
+    std::swap(batch_updates, next_batch_updates);
+    std::swap(batch_deltas, next_batch_deltas);
+  }
+}
+
 SkipListNode* EulerTourTree::get_root(node_id_t u) {
   return ett_nodes[u].get_root();
 }
@@ -64,61 +208,88 @@ uint32_t EulerTourTree::get_size(node_id_t u) {
   return ett_nodes[u].get_size();
 }
 
-EulerTourNode::EulerTourNode(long seed, node_id_t vertex, uint32_t tier) : seed(seed), vertex(vertex), tier(tier) {
+void EulerTourTree::get_cc_labels(ComponentLabels& cc, bool with_lists) {
+  // Each tour ends in the sentinel of exactly one of its vertices
+  std::vector<SkipListNode*> sentinels;
+  for (EulerTourNode& node : ett_nodes) {
+    if (SkipListNode* sentinel = node.get_sentinel())
+      sentinels.push_back(sentinel);
+  }
+  cc.labels.resize(ett_nodes.size());
+  cc.num_components = sentinels.size();
+  // Label the trees in parallel, each with one scan of the bottom level of its skiplist
+  #pragma omp parallel for schedule(dynamic, 64)
+  for (node_id_t c = 0; c < cc.num_components; c++) {
+    for (SkipListNode* curr = sentinels[c]->get_first()->next(); curr; curr = curr->next())
+      cc.labels[curr->node->vertex] = c;
+  }
+  if (with_lists)
+    cc.build_lists();
+}
+
+EulerTourNode::EulerTourNode(node_id_t vertex, uint32_t tier, SkipListAllocator* allocator, SketchPool* sketch_pool, uint64_t* list_epoch) :
+    allocator(allocator), sketch_pool(sketch_pool), list_epoch(list_epoch), vertex(vertex), tier(tier) {
   // Initialize sentinel
   this->make_edge(nullptr, nullptr);
 }
 
-EulerTourNode::EulerTourNode(long seed) : seed(seed) {
+EulerTourNode::EulerTourNode(SkipListAllocator* allocator, SketchPool* sketch_pool, uint64_t* list_epoch) :
+    allocator(allocator), sketch_pool(sketch_pool), list_epoch(list_epoch) {
   // Initialize sentinel
   this->make_edge(nullptr, nullptr);
 }
 
 EulerTourNode::~EulerTourNode() {
-  // Final boundary nodes are a memory leak
-  // Need to somehow delete all the skiplist nodes at the end
-  // for (auto edge : edges)
-  //   edge.second->uninit_element(false);
+  // The skiplist nodes are freed by the tree, all at once
 }
 
-SkipListNode* EulerTourNode::make_edge(EulerTourNode* other, Sketch* temp_sketch) {
+void EulerTourNode::reset() {
+  edges.clear();
+  allowed_caller = nullptr;
+  this->make_edge(nullptr, nullptr);
+}
+
+SkipListNode* EulerTourNode::make_edge(EulerTourNode* other, SkipListNode* temp_agg) {
   assert(!other || this->tier == other->tier);
   //Constructing a new SkipListNode with pointer to this ETT object
   SkipListNode* node;
   if (allowed_caller == nullptr) {
     node = SkipListNode::init_element(this, true);
     allowed_caller = node;
-    if (temp_sketch != nullptr) {
-      node->update_path_agg(temp_sketch);
-      temp_sketch->zero_contents();
-    }
+    if (temp_agg != nullptr)
+      node->update_path_agg(temp_agg);
   } else {
     node = SkipListNode::init_element(this, false);
   }
   //Add the new SkipListNode to the edge list
-  return this->edges.emplace(std::make_pair(other, node)).first->second;
+  return this->edges.insert(other, node);
   //Returns the new node pointer or the one that already existed if it did
 }
 
-void EulerTourNode::delete_edge(EulerTourNode* other, Sketch* temp_sketch) {
+void EulerTourNode::delete_edge(EulerTourNode* other, SkipListNode* temp_agg) {
   assert(!other || this->tier == other->tier);
-  SkipListNode* node_to_delete = this->edges[other];
+  SkipListNode* node_to_delete = this->edges.find(other);
   this->edges.erase(other);
+  // An occurrence that is not alone in its list is cut straight out of it
+  bool alone = !node_to_delete->prev() && !node_to_delete->next();
+  if (!alone)
+    SkipListNode::excise(node_to_delete);
   if (node_to_delete == allowed_caller) {
     if (this->edges.empty()) {
       allowed_caller = nullptr;
-      node_to_delete->process_updates();
-      // std::cout << node_to_delete << std::endl;
-      temp_sketch->merge(*node_to_delete->sketch_agg);
-      node_to_delete->sketch_agg = nullptr;
+      // temp_agg is in no list, so this just moves the aggregate there
+      temp_agg->update_path_agg(node_to_delete);
     } else {
-      allowed_caller = this->edges.begin()->second;
-      node_to_delete->process_updates();
-      allowed_caller->update_path_agg(node_to_delete->sketch_agg);
-      node_to_delete->sketch_agg = nullptr; // We just gave the sketch to new allowed caller
+      allowed_caller = this->edges.any();
+      allowed_caller->update_path_agg(node_to_delete);
     }
   }
-  node_to_delete->uninit_element(true);
+  node_to_delete->uninit_element(alone);
+}
+
+SkipListNode* EulerTourNode::front_occurrence() {
+  SkipListNode* first = this->allowed_caller->get_first()->next();
+  return first->node == this ? first : this->edges.any();
 }
 
 SkipListNode* EulerTourNode::update_sketch(vec_t update_idx) {
@@ -141,21 +312,21 @@ uint32_t EulerTourNode::get_size() {
 }
 
 bool EulerTourNode::has_edge_to(EulerTourNode* other) {
-  return !(this->edges.find(other) == this->edges.end());
+  return this->edges.find(other) != nullptr;
 }
 
 std::set<EulerTourNode*> EulerTourNode::get_component() {
   return this->allowed_caller->get_component();
 }
 
-bool EulerTourNode::link(EulerTourNode& other, Sketch* temp_sketch) {
+bool EulerTourNode::link(EulerTourNode& other, SkipListNode* temp_agg) {
   assert(this->tier == other.tier);
-  SkipListNode* this_sentinel = this->edges.begin()->second->get_last();
-  SkipListNode* other_sentinel = other.edges.begin()->second->get_last();
+  SkipListNode* this_sentinel = this->edges.any()->get_last();
+  SkipListNode* other_sentinel = other.edges.any()->get_last();
 
   // There should always be a sentinel
-  assert(this_sentinel == this_sentinel->node->edges.at(nullptr));
-  assert(other_sentinel == other_sentinel->node->edges.at(nullptr));
+  assert(this_sentinel == this_sentinel->node->edges.find(nullptr));
+  assert(other_sentinel == other_sentinel->node->edges.find(nullptr));
 
   // If the nodes are already part of the same tree, don't link
   if (this_sentinel == other_sentinel) {
@@ -170,19 +341,20 @@ bool EulerTourNode::link(EulerTourNode& other, Sketch* temp_sketch) {
   // A, construct B, DED, C, construct D, BA
   // ^                    ^
   // '--------------------'--- might be null
+  // Splitting at an occurrence that already starts its tour is free, so prefer those
 
-  SkipListNode* aux_this_right = this->edges.begin()->second;
+  SkipListNode* aux_this_right = this->front_occurrence();
   SkipListNode* aux_this_left = SkipListNode::split_left(aux_this_right);
 
-  // Unlink and destroy other_sentinel
-  SkipListNode* aux_other = SkipListNode::split_left(other_sentinel);
-  other_sentinel->node->delete_edge(nullptr, temp_sketch);
+  // Cut other_sentinel out of its tour and destroy it
+  bool other_is_sentinel_only = !other_sentinel->prev();
+  other_sentinel->node->delete_edge(nullptr, temp_agg);
 
   SkipListNode* aux_other_left, *aux_other_right;
-  if (aux_other == nullptr) {
+  if (other_is_sentinel_only) {
     aux_other_right = aux_other_left = nullptr;
   } else {
-    aux_other_right = other.edges.begin()->second;
+    aux_other_right = other.front_occurrence();
     aux_other_left = SkipListNode::split_left(aux_other_right);
   }
 
@@ -191,8 +363,8 @@ bool EulerTourNode::link(EulerTourNode& other, Sketch* temp_sketch) {
   // R  LR           L    R  LR           L
   // N                    N
 
-  SkipListNode* aux_edge_left = this->make_edge(&other, temp_sketch);
-  SkipListNode* aux_edge_right = other.make_edge(this, temp_sketch);
+  SkipListNode* aux_edge_left = this->make_edge(&other, temp_agg);
+  SkipListNode* aux_edge_right = other.make_edge(this, temp_agg);
 
   SkipListNode::join(aux_this_left, aux_edge_left, aux_other_right,
       aux_other_left, aux_edge_right, aux_this_right);
@@ -200,36 +372,45 @@ bool EulerTourNode::link(EulerTourNode& other, Sketch* temp_sketch) {
   return true;
 }
 
-bool EulerTourNode::cut(EulerTourNode& other, Sketch* temp_sketch) {
+bool EulerTourNode::cut(EulerTourNode& other, SkipListNode* temp_agg) {
   assert(this->tier == other.tier);
-  if (this->edges.find(&other) == this->edges.end()) {
-    assert(other.edges.find(this) == other.edges.end());
+  if (!this->edges.find(&other)) {
+    assert(!other.edges.find(this));
     return false;
   }
-  SkipListNode* e1 = this->edges[&other];
-  SkipListNode* e2 = other.edges[this];
-
-  SkipListNode* frag1r = SkipListNode::split_right(e1);
+  SkipListNode* e1 = this->edges.find(&other);
+  SkipListNode* e2 = other.edges.find(this);
+
+  // The tour is L e M e' R for the two occurrences e and e' in order, where L and M
+  // might be null. Split M out, cut e and e' out of their lists, then join L with R
+  // and M with a new sentinel for the vertex on its side.
+  SkipListNode* e1_left = e1->prev();
+  SkipListNode* e1_right = e1->next();
+  SkipListNode* e2_left = e2->prev();
+  SkipListNode* e2_right = e2->next();
+
+  SkipListNode::split_right(e1);
   bool order_is_e1e2 = e2->get_last() != e1;
-  SkipListNode* frag1l = SkipListNode::split_left(e1);
-  this->delete_edge(&other, temp_sketch);
-  SkipListNode* frag2r = SkipListNode::split_right(e2);
-  SkipListNode* frag2l = SkipListNode::split_left(e2);
-  other.delete_edge(this, temp_sketch);
-
+  SkipListNode* frag_l, *frag_m, *frag_r;
   if (order_is_e1e2) {
-    // e1 is to the left of e2
-    // e2 should be made into a sentinel
-    SkipListNode* sentinel = other.make_edge(nullptr, temp_sketch);
-    SkipListNode::join(frag2l, sentinel);
-    SkipListNode::join(frag1l, frag2r);
+    frag_l = e1_left;
+    frag_m = e1_right != e2 ? e1_right : nullptr;
+    frag_r = e2_right;
+    SkipListNode::split_left(e2);
   } else {
-    // e2 is to the left of e1
-    // e1 should be made into a sentinel
-    SkipListNode* sentinel = this->make_edge(nullptr, temp_sketch);
-    SkipListNode::join(frag2r, sentinel);
-    SkipListNode::join(frag2l, frag1r);
+    frag_l = e2_left;
+    frag_m = e2_right != e1 ? e2_right : nullptr;
+    frag_r = e1_right;
+    if (frag_m) SkipListNode::split_right(e2);
   }
+  this->delete_edge(&other, temp_agg);
+  other.delete_edge(this, temp_agg);
+
+  // The vertex whose subtree was M becomes the root of its new tree
+  EulerTourNode& m_vertex = order_is_e1e2 ? other : *this;
+  SkipListNode* sentinel = m_vertex.make_edge(nullptr, temp_agg);
+  SkipListNode::join(frag_m, sentinel);
+  SkipListNode::join(frag_l, frag_r);
 
   return true;
 }
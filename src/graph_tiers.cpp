@@ -33,15 +33,37 @@ GraphTiers::GraphTiers(node_id_t num_nodes) : link_cut_tree(num_nodes) {
     std::cout << "SEED: " << seed << std::endl;
     rng.seed(seed);
 	dist(rng); // To give 1:1 correspondence with MPI seeds
+#ifdef ETT_VERTEX_MAJOR
+	// Store the nodes of every tier of a vertex next to each other
+	ett_node_storage = EulerTourNodeArray::allocate((size_t)num_nodes*num_tiers);
+#endif
 	for (uint32_t i = 0; i < num_tiers; i++) {
 		int tier_seed = dist(rng);
+#ifdef ETT_VERTEX_MAJOR
+		ett.emplace_back(num_nodes, i, tier_seed, skiplist_buffer_cap, ett_node_storage + i, num_tiers);
+#else
 		ett.emplace_back(num_nodes, i, tier_seed);
+#endif
 	}
 
 	root_nodes.reserve(num_tiers*2);
 }
 
-GraphTiers::~GraphTiers() {}
+GraphTiers::~GraphTiers() {
+	if (ett_node_storage) {
+		// The ETTs destroy their nodes before the storage goes away
+		size_t num_ett_nodes = ett.empty() ? 0 : ett.size()*ett[0].ett_nodes.size();
+		ett.clear();
+		EulerTourNodeArray::deallocate(ett_node_storage, num_ett_nodes);
+	}
+}
+
+void GraphTiers::reset() {
+	#pragma omp parallel for
+	for (uint32_t i = 0; i < ett.size(); i++)
+		ett[i].reset();
+	link_cut_tree.reset();
+}
 
 void GraphTiers::update(GraphUpdate update) {
 	edge_id_t edge = VERTICES_TO_EDGE(update.edge.src, update.edge.dst);
@@ -56,8 +78,11 @@ void GraphTiers::update(GraphUpdate update) {
 			ett[i].cut(update.edge.src, update.edge.dst);
 			ENDPOINT_CANARY("Cutting Tier " << i << " ETT With", update.edge.src, update.edge.dst);
 		}
-		root_nodes[2*i] = ett[i].update_sketch(update.edge.src, (vec_t)edge);
-		root_nodes[2*i+1] = ett[i].update_sketch(update.edge.dst, (vec_t)edge);
+		// The update cancels out above the first node both paths share, so when the endpoints
+		// are in the same tree the root is left as it was along with its cached sample
+		std::pair<SkipListNode*, SkipListNode*> roots = ett[i].update_sketches(update.edge.src, update.edge.dst, (vec_t)edge);
+		root_nodes[2*i] = roots.first;
+		root_nodes[2*i+1] = roots.second;
 		ENDPOINT_CANARY("Updating Sketch With", update.edge.src, update.edge.dst);
 	}
 	STOP(sketch_time, su);
@@ -77,10 +102,7 @@ void GraphTiers::refresh(GraphUpdate update) {
 		uint32_t tier_size1 = root_nodes[2*tier]->size;
 		uint32_t next_size1 = root_nodes[2*(tier+1)]->size;
 		if (tier_size1 == next_size1) {
-			root_nodes[2*tier]->process_updates();
-			Sketch* ett_agg1 = root_nodes[2*tier]->sketch_agg;
-			ett_agg1->reset_sample_state();
-			SketchSample query_result1 = ett_agg1->sample();
+			SketchSample query_result1 = root_nodes[2*tier]->sample_agg();
 			if (query_result1.result == GOOD) {
 				isolated = true;
 				continue;
@@ -90,10 +112,7 @@ void GraphTiers::refresh(GraphUpdate update) {
 		uint32_t tier_size2 = root_nodes[2*tier+1]->size;
 		uint32_t next_size2 = root_nodes[2*(tier+1)+1]->size;
 		if (tier_size2 == next_size2) {
-			root_nodes[2*tier+1]->process_updates();
-			Sketch* ett_agg2 = root_nodes[2*tier+1]->sketch_agg;
-			ett_agg2->reset_sample_state();
-			SketchSample query_result2 = ett_agg2->sample();
+			SketchSample query_result2 = root_nodes[2*tier+1]->sample_agg();
 			if (query_result2.result == GOOD) {
 				isolated = true;
 				continue;
@@ -118,12 +137,9 @@ void GraphTiers::refresh(GraphUpdate update) {
 
 			START(agg);
 			SkipListNode* root = ett[tier].get_root(v);
-			root->process_updates();
-			Sketch* ett_agg = root->sketch_agg;
 			STOP(ett_get_agg, agg);
 			START(sq);
-			ett_agg->reset_sample_state();
-			SketchSample query_result = ett_agg->sample();
+			SketchSample query_result = root->sample_agg();
 			STOP(sketch_query, sq);
 
 			// Check for new edge to eliminate isolation
@@ -135,23 +151,19 @@ void GraphTiers::refresh(GraphUpdate update) {
 			node_id_t a = (node_id_t)edge;
 			node_id_t b = (node_id_t)(edge>>32);
 
-			// Check if a path exists between the edge's endpoints
+			// Check if a path exists between the edge's endpoints, and find the maximum tier
+			// edge on the path and what tier it first appeared on
 			START(lct1);
-			void* a_root = link_cut_tree.find_root(a);
-			void* b_root = link_cut_tree.find_root(b);
+			LinkCutTree::CycleQueryResult cycle = link_cut_tree.cycle_query(a, b);
 			STOP(lct_time, lct1);
-			if (a_root == b_root) {
-				START(lct2);
-				// Find the maximum tier edge on the path and what tier it first appeared on
-				std::pair<edge_id_t, uint32_t> max = link_cut_tree.path_aggregate(a,b);
-				node_id_t c = (node_id_t)max.first;
-				node_id_t d = (node_id_t)(max.first>>32);
-				STOP(lct_time, lct2);
+			if (cycle.connected) {
+				node_id_t c = (node_id_t)cycle.max_edge;
+				node_id_t d = (node_id_t)(cycle.max_edge>>32);
 
 				// Remove the maximum tier edge on all paths where it exists
 				START(ett1);
 				#pragma omp parallel for
-				for (uint32_t i = max.second; i < ett.size(); i++) {
+				for (uint32_t i = cycle.max_weight; i < ett.size(); i++) {
 					ett[i].cut(c,d);
 					ENDPOINT_CANARY("Cutting Tier " << i << " ETT With", c, d);
 				}
@@ -177,21 +189,19 @@ void GraphTiers::refresh(GraphUpdate update) {
 }
 
 std::vector<std::set<node_id_t>> GraphTiers::get_cc() {
-	std::vector<std::set<node_id_t>> cc;
-	std::set<EulerTourNode*> visited;
-	int top = ett.size()-1;
-	for (uint32_t i = 0; i < ett[top].ett_nodes.size(); i++) {
-		if (visited.find(&ett[top].ett_nodes[i]) == visited.end()) {
-			std::set<EulerTourNode*> pointer_component = ett[top].ett_nodes[i].get_component();
-			std::set<node_id_t> component;
-			for (auto pointer : pointer_component) {
-				component.insert(pointer->vertex);
-				visited.insert(pointer);
-			}
-			cc.push_back(component);
-		}
-	}
-	return cc;
+	ComponentLabels cc;
+	get_cc_labels(cc);
+	return cc.to_sets();
+}
+
+void GraphTiers::get_cc_labels(ComponentLabels& cc, bool with_lists) {
+	// The top tier holds the spanning forest of the whole graph
+	ett.back().get_cc_labels(cc, with_lists);
+}
+
+node_id_t GraphTiers::num_components() {
+	// The link cut tree holds the spanning forest and counts its trees as they are linked and cut
+	return this->link_cut_tree.get_num_trees();
 }
 
 bool GraphTiers::is_connected(node_id_t a, node_id_t b) {
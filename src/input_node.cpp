@@ -4,8 +4,9 @@
 long normal_refreshes = 0;
 long dt_operation_time = 0;
 
-InputNode::InputNode(node_id_t num_nodes, uint32_t num_tiers, int batch_size, int seed) :
-    num_nodes(num_nodes), num_tiers(num_tiers), link_cut_tree(num_nodes), query_ett(num_nodes, 0, seed) {
+InputNode::InputNode(node_id_t num_nodes, uint32_t num_tiers, int batch_size) :
+    num_nodes(num_nodes), num_tiers(num_tiers), link_cut_tree(num_nodes), query_ett(num_nodes, 0),
+    component_sizes(num_nodes) {
     update_buffer = (UpdateMessage*) malloc(sizeof(UpdateMessage)*(batch_size+1));
     buffer_capacity = batch_size+1;
     UpdateMessage msg;
@@ -31,6 +32,18 @@ void InputNode::update(GraphUpdate update) {
         process_updates();
 }
 
+void InputNode::forest_link(node_id_t a, node_id_t b, uint32_t weight) {
+    component_sizes.merge(query_ett.get_aggregate(a).size, query_ett.get_aggregate(b).size);
+    link_cut_tree.link(a, b, weight);
+    query_ett.link(a, b);
+}
+
+void InputNode::forest_cut(node_id_t a, node_id_t b) {
+    link_cut_tree.cut(a, b);
+    query_ett.cut(a, b);
+    component_sizes.split(query_ett.get_aggregate(a).size, query_ett.get_aggregate(b).size);
+}
+
 void InputNode::process_updates() {
     if (buffer_size == 1)
         return;
@@ -50,8 +63,7 @@ void InputNode::process_updates() {
         split_revert_buffer[i] = MAX_INT;
         unlikely_if (update.type == DELETE && link_cut_tree.has_edge(update.edge.src, update.edge.dst)) {
             split_revert_buffer[i] = link_cut_tree.get_edge_weight(update.edge.src, update.edge.dst);
-            link_cut_tree.cut(update.edge.src, update.edge.dst);
-            query_ett.cut(update.edge.src, update.edge.dst);
+            forest_cut(update.edge.src, update.edge.dst);
         }
     }
     // Attempt to do the entire batch parallel with greedy refresh
@@ -68,8 +80,7 @@ void InputNode::process_updates() {
         GraphUpdate update = update_buffer[update_idx].update;
         // There could be a cut on a later update that needs to be rolled back
         unlikely_if (split_revert_buffer[update_idx-1] != MAX_INT) {
-            link_cut_tree.link(update.edge.src, update.edge.dst, split_revert_buffer[update_idx-1]);
-            query_ett.link(update.edge.src, update.edge.dst);
+            forest_link(update.edge.src, update.edge.dst, split_revert_buffer[update_idx-1]);
         }
     }
     // Update the isolation history
@@ -86,8 +97,7 @@ void InputNode::process_updates() {
         GraphUpdate update = update_buffer[update_idx].update;
         START(dt_operation_timer1);
         unlikely_if (update.type == DELETE && link_cut_tree.has_edge(update.edge.src, update.edge.dst)) {
-            link_cut_tree.cut(update.edge.src, update.edge.dst);
-            query_ett.cut(update.edge.src, update.edge.dst);
+            forest_cut(update.edge.src, update.edge.dst);
         }
         STOP(dt_operation_time, dt_operation_timer1);
         uint32_t start_tier = 0;
@@ -113,11 +123,11 @@ void InputNode::process_updates() {
                 this_update_isolated = true;
                 // Process a LCT query message first
                 LctResponseMessage response_message;
-                response_message.connected = link_cut_tree.find_root(update_message.endpoint1) == link_cut_tree.find_root(update_message.endpoint2);
-                if (response_message.connected) {
-                    std::pair<edge_id_t, uint32_t> max = link_cut_tree.path_aggregate(update_message.endpoint1, update_message.endpoint2);
-                    response_message.cycle_edge = max.first;
-                    response_message.weight = max.second;
+                LinkCutTree::CycleQueryResult cycle = link_cut_tree.cycle_query(update_message.endpoint1, update_message.endpoint2);
+                response_message.connected = cycle.connected;
+                if (cycle.connected) {
+                    response_message.cycle_edge = cycle.max_edge;
+                    response_message.weight = cycle.max_weight;
                 }
                 MPI_Send(&response_message, sizeof(LctResponseMessage), MPI_BYTE, rank, 0, MPI_COMM_WORLD);
 
@@ -128,12 +138,10 @@ void InputNode::process_updates() {
                     bcast(&update_message, sizeof(EttUpdateMessage), rank);
                     START(dt_operation_timer2);
                     if (update_message.type == LINK) {
-                        link_cut_tree.link(update_message.endpoint1, update_message.endpoint2, update_message.start_tier);
-                        query_ett.link(update_message.endpoint1, update_message.endpoint2);
+                        forest_link(update_message.endpoint1, update_message.endpoint2, update_message.start_tier);
                         break;
                     } else if (update_message.type == CUT) {
-                        link_cut_tree.cut(update_message.endpoint1, update_message.endpoint2);
-                        query_ett.cut(update_message.endpoint1, update_message.endpoint2);
+                        forest_cut(update_message.endpoint1, update_message.endpoint2);
                     }
                     STOP(dt_operation_time, dt_operation_timer2);
                 }
@@ -172,6 +180,21 @@ std::vector<std::set<node_id_t>> InputNode::cc_query() {
     return query_ett.cc_query();
 }
 
+node_id_t InputNode::num_components() {
+    process_all_updates();
+    return link_cut_tree.get_num_trees();
+}
+
+node_id_t InputNode::component_size(node_id_t v) {
+    process_all_updates();
+    return query_ett.get_aggregate(v).size;
+}
+
+std::vector<node_id_t> InputNode::largest_components(size_t k) {
+    process_all_updates();
+    return component_sizes.top_k(k);
+}
+
 void InputNode::end() {
     process_all_updates();
     // Tell all nodes the stream is over
@@ -1,198 +1,130 @@
 #include "../include/link_cut_tree.h"
 #include <cassert>
+#include <tuple>
+#include <utility>
 
-void LinkCutNode::set_parent(LinkCutNode* parent) { this->parent = parent; }
-void LinkCutNode::set_dparent(LinkCutNode* dparent) { this->dparent = dparent; }
+static_assert(sizeof(LinkCutNode) <= 64, "LinkCutNode should fit in a cache line");
+
+void LinkCutNode::set_parent(LinkCutNode* parent) { this->parent = index_of(parent); }
+void LinkCutNode::set_dparent(LinkCutNode* dparent, uint32_t weight) {
+    this->dparent = index_of(dparent);
+    this->dparent_weight = weight;
+}
 void LinkCutNode::set_max(uint32_t weight){ this->max = weight; }
-void LinkCutNode::set_reversed(bool reversed){ this->reversed = reversed; }
-void LinkCutNode::reverse() { this->reversed = !this->reversed; }
+void LinkCutNode::set_reversed(bool reversed){ this->id_and_reversed = this->index() | (reversed ? reversed_bit : 0); }
+void LinkCutNode::reverse() { this->id_and_reversed ^= reversed_bit; }
 
 void LinkCutNode::link_left(LinkCutNode* other) {
-    this->left = other;
+    this->left = index_of(other);
     if (other != nullptr) {
-        other->set_parent(this);
+        other->parent = this->index();
     }
-    this->rebuild_max();
+    this->rebuild_aggregates();
     assert(this->get_left() == nullptr || this->get_left()->get_parent() == this);
 }
 
 void LinkCutNode::link_right(LinkCutNode* other) {
-    this->right = other;
+    this->right = index_of(other);
     if (other != nullptr) {
-        other->set_parent(this);
+        other->parent = this->index();
     }
-    this->rebuild_max();
+    this->rebuild_aggregates();
     assert(this->get_right() == nullptr || this->get_right()->get_parent() == this);
 }
 
-LinkCutNode* LinkCutNode::get_left() { return this->left; }
-LinkCutNode* LinkCutNode::get_right() { return this->right; }
-LinkCutNode* LinkCutNode::get_parent() { return this->parent; }
-LinkCutNode* LinkCutNode::get_dparent() { return this->dparent; }
-LinkCutNode* LinkCutNode::get_head() { return this->head; }
-LinkCutNode* LinkCutNode::get_tail() { return this->tail; }
-std::pair<edge_id_t, uint32_t> LinkCutNode::get_max_edge() { return {this->max_edge, this->max}; }
-bool LinkCutNode::get_reversed() { return this->reversed; }
-
-LinkCutNode* LinkCutNode::recompute_head() {
-    LinkCutNode* curr = this;
-    LinkCutNode* next;
-    bool reversal_state = false;
-    while (curr != nullptr) {
-        reversal_state = reversal_state != curr->reversed;
-        if((next = reversal_state ? curr->right : curr->left) == nullptr) { this->head = curr; }
-        curr = next;
-    }
-    return this->head;
-}
-
-LinkCutNode* LinkCutNode::recompute_tail() {
-    LinkCutNode* curr = this;
-    LinkCutNode* next;
-    bool reversal_state = false;
-    while (curr != nullptr) {
-        reversal_state = reversal_state != curr->reversed;
-        if((next = reversal_state ? curr->left : curr->right) == nullptr) { this->tail = curr; }
-        curr = next;
-    }
-    return this->tail;
-}
-
-// void inorder(LinkCutNode* node, std::vector<LinkCutNode*>& nodes, bool reversal_state) {
-//     if (node != nullptr) {
-//         reversal_state = reversal_state != node->get_reversed();
-//         if (!reversal_state) {
-//             inorder(node->get_left(), nodes, reversal_state);
-//             nodes.push_back(node);
-//             inorder(node->get_right(), nodes, reversal_state);
-//         } else {
-//             inorder(node->get_right(), nodes, reversal_state);
-//             nodes.push_back(node);
-//             inorder(node->get_left(), nodes, reversal_state);
-//         }
-//     }
-// }
-
-// std::vector<LinkCutNode*> get_inorder(LinkCutNode* node) {
-//     LinkCutNode* curr = node;
-//     LinkCutNode* root;
-//     while (curr) {
-//         if (curr->get_parent() == nullptr) { root = curr; }
-//         curr = curr->get_parent();
-//     }
-//     std::vector<LinkCutNode*> nodes;
-//     inorder(root, nodes, false);
-//     return nodes;
-// }
-
-void LinkCutNode::correct_reversals() {
-    //std::vector<LinkCutNode*> inorder = get_inorder(this);
-    //Get the XOR of all reversed booleans from this node to root
-    bool reversal_state = 0;
-    LinkCutNode* curr = this;
-    while (curr) {
-        reversal_state = reversal_state != curr->reversed;
-        curr = curr->parent;
-    }
-    //Travel back up performing the reversals where needed
-    curr = this;
-    LinkCutNode* prev = nullptr;
-    while (curr) {
-        bool next_reversal_state = reversal_state != curr->reversed;
-        if (reversal_state) {
-            LinkCutNode* temp = curr->left;
-            curr->left = curr->right;
-            curr->right = temp;
-            if (curr->left && curr->left != prev) {
-                curr->left->set_reversed(!curr->left->reversed);
-            }
-            if (curr->right && curr->right != prev) {
-                curr->right->set_reversed(!curr->right->reversed);
-            }
-        }
-        curr->set_reversed(false);
-        reversal_state = next_reversal_state;
-        prev = curr;
-        curr = curr->parent;
-    }
-    //assert(inorder == get_inorder(this));
-}
-
-void LinkCutNode::make_preferred_edge(edge_id_t e) {
-    assert(this->preferred_edges.first == MAX_UINT64 || this->preferred_edges.second == MAX_UINT64);
-    if (this->preferred_edges.first == MAX_UINT64) {
-        this->preferred_edges.first = e;
-    } else {
-        this->preferred_edges.second = e;
-    }
+LinkCutNode* LinkCutNode::get_left() { return node_at(this->left); }
+LinkCutNode* LinkCutNode::get_right() { return node_at(this->right); }
+LinkCutNode* LinkCutNode::get_parent() { return node_at(this->parent); }
+LinkCutNode* LinkCutNode::get_dparent() { return node_at(this->dparent); }
+LinkCutNode* LinkCutNode::get_head() { return node_at(this->first()); }
+LinkCutNode* LinkCutNode::get_tail() { return node_at(this->last()); }
+std::pair<edge_id_t, uint32_t> LinkCutNode::get_max_edge() {
+    node_id_t a = this->max_edge >> 32, b = (node_id_t)this->max_edge;
+    return {VERTICES_TO_EDGE(a, b), this->max};
 }
-
-void LinkCutNode::unmake_preferred_edge(edge_id_t e) {
-    assert(this->preferred_edges.first == e || this->preferred_edges.second == e);
-    if (this->preferred_edges.first == e) {
-        this->preferred_edges.first = MAX_UINT64;
-    } else {
-        this->preferred_edges.second = MAX_UINT64;
-    }
+bool LinkCutNode::get_reversed() { return this->id_and_reversed & reversed_bit; }
+
+void LinkCutNode::push_down() {
+    if (!this->get_reversed()) return;
+    std::swap(this->left, this->right);
+    std::swap(this->head, this->tail);
+    if (this->left != nil) this->get_left()->reverse();
+    if (this->right != nil) this->get_right()->reverse();
+    this->set_reversed(false);
 }
 
-void LinkCutNode::insert_edge(edge_id_t e, uint32_t weight) {
-    assert(this->edges.count(e) == 0);
-    this->edges.insert({e, weight});
+void LinkCutNode::make_preferred_edge(node_id_t neighbor, uint32_t weight) {
+    assert(this->preferred_edges[0].neighbor == nil || this->preferred_edges[1].neighbor == nil);
+    PreferredEdge& slot = this->preferred_edges[this->preferred_edges[0].neighbor == nil ? 0 : 1];
+    slot.neighbor = neighbor;
+    slot.weight = weight;
 }
 
-void LinkCutNode::remove_edge(edge_id_t e) {
-    assert(this->edges.count(e) == 1);
-    this->edges.erase(e);
+uint32_t LinkCutNode::unmake_preferred_edge(node_id_t neighbor) {
+    assert(this->preferred_edges[0].neighbor == neighbor || this->preferred_edges[1].neighbor == neighbor);
+    PreferredEdge& slot = this->preferred_edges[this->preferred_edges[0].neighbor == neighbor ? 0 : 1];
+    uint32_t weight = slot.weight;
+    slot.neighbor = nil;
+    slot.weight = 0;
+    return weight;
 }
 
-bool LinkCutNode::has_edge(edge_id_t e) {
-    return (this->edges.find(e) != this->edges.end());
+void LinkCutNode::remove_edge_weight(node_id_t neighbor) {
+    // The edge can stay preferred or the dparent edge until its path is split or spliced
+    for (PreferredEdge& slot : this->preferred_edges)
+        if (slot.neighbor == neighbor) slot.weight = 0;
+    if (this->dparent == neighbor) this->dparent_weight = 0;
 }
 
-uint32_t LinkCutNode::get_edge_weight(edge_id_t e) {
-    return this->edges[e];
+uint32_t* LinkCutNode::find_edge_weight(node_id_t neighbor) {
+    for (PreferredEdge& slot : this->preferred_edges)
+        if (slot.neighbor == neighbor) return &slot.weight;
+    return this->dparent == neighbor ? &this->dparent_weight : nullptr;
 }
 
-void LinkCutNode::rebuild_max() {
+void LinkCutNode::rebuild_aggregates() {
     uint32_t max = 0;
     edge_id_t max_edge = 0;
+    node_id_t id = this->index();
 
-    if (this->preferred_edges.first != MAX_UINT64 && this->edges.find(this->preferred_edges.first) != this->edges.end() && this->edges[this->preferred_edges.first] > max) {
-        max = this->edges[this->preferred_edges.first];
-        max_edge = this->preferred_edges.first;
-    }
-    if (this->preferred_edges.second != MAX_UINT64 && this->edges.find(this->preferred_edges.second) != this->edges.end() && this->edges[this->preferred_edges.second] > max) {
-        max = this->edges[this->preferred_edges.second];
-        max_edge = this->preferred_edges.second;
+    for (const PreferredEdge& slot : this->preferred_edges) {
+        if (slot.weight > max) {
+            max = slot.weight;
+            max_edge = ((edge_id_t)id << 32) + slot.neighbor;
+        }
     }
-    if (this->left && this->left->max > max) {
-        max = this->left->max;
-        max_edge = this->left->max_edge;
+    LinkCutNode* left = this->get_left();
+    if (left && left->max > max) {
+        max = left->max;
+        max_edge = left->max_edge;
     }
-    if (this->right && this->right->max > max) {
-        max = this->right->max;
-        max_edge = this->right->max_edge;
+    LinkCutNode* right = this->get_right();
+    if (right && right->max > max) {
+        max = right->max;
+        max_edge = right->max_edge;
     }
 
     this->set_max(max);
     this->max_edge = max_edge;
+    // The children's ends already account for their own reversed flags
+    this->head = left ? left->first() : id;
+    this->tail = right ? right->last() : id;
 }
 
 void LinkCutNode::rotate_up() {
-    LinkCutNode* parent = this->parent;
-    LinkCutNode* grandparent = parent->parent;
+    LinkCutNode* parent = this->get_parent();
+    LinkCutNode* grandparent = parent->get_parent();
 
-    if (parent->left == this) {
-        parent->link_left(this->right);
+    if (parent->left == this->index()) {
+        parent->link_left(this->get_right());
         this->link_right(parent);
     } else {
-        parent->link_right(this->left);
+        parent->link_right(this->get_left());
         this->link_left(parent);
     }
 
     if (grandparent != nullptr) {
-        if (grandparent->left == parent) {
+        if (grandparent->left == parent->index()) {
             grandparent->link_left(this);
         } else {
             grandparent->link_right(this);
@@ -203,15 +135,18 @@ void LinkCutNode::rotate_up() {
 }
 
 LinkCutNode* LinkCutNode::splay() {
-    this->correct_reversals();
-
-    while (this->parent != nullptr) {
-        LinkCutNode* parent = this->parent;
-        LinkCutNode* grandparent = parent->parent;
+    // Reversals are pushed down from the top of each rotation before looking at its children,
+    // which is enough since a reversal above a subtree does not change how it is rotated
+    while (this->parent != nil) {
+        LinkCutNode* parent = this->get_parent();
+        LinkCutNode* grandparent = parent->get_parent();
+        if (grandparent != nullptr) grandparent->push_down();
+        parent->push_down();
+        this->push_down();
         if (grandparent == nullptr) {
             // zig
             this->rotate_up();
-        } else if ((grandparent->left == parent) == (parent->left == this)) {
+        } else if ((grandparent->left == parent->index()) == (parent->left == this->index())) {
             // zig-zig
             parent->rotate_up();
             this->rotate_up();
@@ -221,30 +156,35 @@ LinkCutNode* LinkCutNode::splay() {
             this->rotate_up();
         }
     }
-    this->recompute_head();
-    this->recompute_tail();
-    this->rebuild_max();
+    this->push_down(); // In case this was the root already
+    this->rebuild_aggregates();
     assert(this->get_parent() == nullptr);
     return this;
 }
 
-LinkCutTree::LinkCutTree(node_id_t num_nodes) : nodes(num_nodes) {}
+LinkCutTree::LinkCutTree(node_id_t num_nodes) : num_trees(num_nodes) {
+    assert(num_nodes <= LinkCutNode::max_nodes);
+    nodes.reserve(num_nodes);
+    for (node_id_t i = 0; i < num_nodes; i++)
+        nodes.emplace_back(i);
+}
+
+void LinkCutTree::reset() {
+    for (node_id_t i = 0; i < nodes.size(); i++)
+        nodes[i] = LinkCutNode(i);
+    num_trees = nodes.size();
+}
 
-LinkCutNode* LinkCutTree::join(LinkCutNode* v, LinkCutNode* w) {
+LinkCutNode* LinkCutTree::join(LinkCutNode* v, LinkCutNode* w, uint32_t weight) {
     assert(v != nullptr && w != nullptr && v->get_parent() == nullptr && w->get_parent() == nullptr);
     LinkCutNode* tail = v->get_tail();
     LinkCutNode* head = w->get_head();
-    node_id_t tail_id = tail-&(this->nodes[0]);
-    node_id_t head_id = head-&(this->nodes[0]);
-    edge_id_t edge = (tail_id < head_id) ? (((edge_id_t)tail_id << 32) + head_id) : (((edge_id_t)head_id << 32) + tail_id);
-    tail->make_preferred_edge(edge);
-    head->make_preferred_edge(edge);
+    tail->make_preferred_edge(head->get_id(), weight);
+    head->make_preferred_edge(tail->get_id(), weight);
     tail->splay();
     head->splay(); // To recompute the aggregate
     assert(tail->get_right() == nullptr);
     tail->link_right(head);
-    tail->recompute_head();
-    tail->recompute_tail();
     return tail;
 }
 
@@ -254,30 +194,25 @@ std::pair<LinkCutNode*, LinkCutNode*> LinkCutTree::split(LinkCutNode* v) {
     LinkCutNode* r = v->get_right();
     LinkCutNode* w = nullptr;
     if (r != nullptr) {
-        w = r->recompute_head();
-        node_id_t v_id = v-&(this->nodes[0]);
-        node_id_t w_id = w-&(this->nodes[0]);
-        edge_id_t edge = (v_id < w_id) ? (((edge_id_t)v_id << 32) + w_id) : (((edge_id_t)w_id << 32) + v_id);
-        v->unmake_preferred_edge(edge);
-        w->unmake_preferred_edge(edge);
+        w = r->get_head();
+        uint32_t weight = v->unmake_preferred_edge(w->get_id());
+        w->unmake_preferred_edge(v->get_id());
         v->link_right(nullptr); // This also recomputes the aggregate for v
         r->set_parent(nullptr);
-        w->set_dparent(v);
+        w->set_dparent(v, weight);
         w->splay(); // Recompute the aggregate for w
-        w->recompute_head();
-        w->recompute_tail();
     }
-    v->recompute_head();
-    v->recompute_tail();
     std::pair<LinkCutNode*, LinkCutNode*> paths = {v, w};
     return paths;
 }
 
 LinkCutNode* LinkCutTree::splice(LinkCutNode* p) {
-    LinkCutNode* v = p->get_head()->get_dparent();
+    LinkCutNode* head = p->get_head();
+    LinkCutNode* v = head->get_dparent();
+    uint32_t weight = head->get_dparent_weight();
     std::pair<LinkCutNode*, LinkCutNode*> paths = this->split(v);
-    p->get_head()->set_dparent(nullptr);
-    return this->join(paths.first, p);
+    head->set_dparent(nullptr, 0);
+    return this->join(paths.first, p, weight);
 }
 
 LinkCutNode* LinkCutTree::expose(LinkCutNode* v) {
@@ -292,8 +227,6 @@ LinkCutNode* LinkCutTree::expose(LinkCutNode* v) {
 LinkCutNode* LinkCutTree::evert(LinkCutNode* v) {
     LinkCutNode* p = this->expose(v);
     p->reverse();
-    p->recompute_head();
-    p->recompute_tail();
     return p;
 }
 
@@ -301,26 +234,26 @@ void LinkCutTree::link(node_id_t v, node_id_t w, uint32_t weight) {
     assert(find_root(v) != find_root(w));
     LinkCutNode* v_node = &this->nodes[v];
     LinkCutNode* w_node = &this->nodes[w];
-    edge_id_t edge = (v < w) ? (((edge_id_t)v << 32) + w) : (((edge_id_t)w << 32) + v);
-    v_node->insert_edge(edge, weight);
-    w_node->insert_edge(edge, weight);
     LinkCutNode* p_v = this->expose(v_node);
     LinkCutNode* p_w = this->evert(w_node);
     assert(p_v->get_tail() == v_node);
     assert(p_w->get_head() == w_node);
-    this->join(p_v, p_w);
+    this->join(p_v, p_w, weight);
+    num_trees--;
 }
 
 void LinkCutTree::cut(node_id_t v, node_id_t w) {
     assert(find_root(v) == find_root(w));
     LinkCutNode* v_node = &this->nodes[v];
     LinkCutNode* w_node = &this->nodes[w];
-    edge_id_t edge = (v < w) ? (((edge_id_t)v << 32) + w) : (((edge_id_t)w << 32) + v);
-    v_node->remove_edge(edge);
-    w_node->remove_edge(edge);
+    v_node->remove_edge_weight(w);
+    w_node->remove_edge_weight(v);
     this->evert(v_node);
     this->expose(v_node);
-    w_node->set_dparent(nullptr);
+    // Every neighbor of the root v is now the head of a path hanging off of it
+    assert(w_node->get_dparent() == v_node);
+    w_node->set_dparent(nullptr, 0);
+    num_trees++;
 }
 
 void* LinkCutTree::find_root(node_id_t v) {
@@ -336,46 +269,60 @@ std::pair<edge_id_t, uint32_t> LinkCutTree::path_aggregate(node_id_t v, node_id_
     return p->get_max_edge();
 }
 
+// Every edge of the forest is either preferred at both of its endpoints, or joins the head of a path to
+// its dparent, so the weights are found on the endpoints without storing the edges anywhere else
+LinkCutTree::CycleQueryResult LinkCutTree::cycle_query(node_id_t v, node_id_t w) {
+    LinkCutNode* v_node = &this->nodes[v];
+    this->evert(v_node);
+    // v is now the root of its tree, so w is connected to it if the path exposed from w starts at v
+    LinkCutNode* p = this->expose(&this->nodes[w]);
+    CycleQueryResult result;
+    if (p->get_head() == v_node) {
+        result.connected = true;
+        std::tie(result.max_edge, result.max_weight) = p->get_max_edge();
+    }
+    return result;
+}
+
 bool LinkCutTree::has_edge(node_id_t v1, node_id_t v2) {
-    edge_id_t e = VERTICES_TO_EDGE(v1, v2);
-    return nodes[v1].has_edge(e);
+    return nodes[v1].find_edge_weight(v2) || nodes[v2].find_edge_weight(v1);
 }
 
 uint32_t LinkCutTree::get_edge_weight(node_id_t v1, node_id_t v2) {
-    edge_id_t e = VERTICES_TO_EDGE(v1, v2);
-    return nodes[v1].get_edge_weight(e);
+    uint32_t* weight = nodes[v1].find_edge_weight(v2);
+    if (!weight) weight = nodes[v2].find_edge_weight(v1);
+    assert(weight);
+    return *weight;
 }
 
 std::vector<std::set<node_id_t>> LinkCutTree::get_cc() {
-	std::map<LinkCutNode*, std::set<node_id_t>> cc_map;
-	std::map<LinkCutNode*, LinkCutNode*> visited;
-	for (uint32_t i = 0; i < nodes.size(); i++) {
-		if (visited.find(&nodes[i]) == visited.end()) {
-            std::set<LinkCutNode*> node_component;
-            LinkCutNode* curr = &nodes[i];
-            while ((curr->get_parent() && visited.find(curr->get_parent()) == visited.end())
-            || (curr->get_head()->get_dparent() && visited.find(curr->get_head()->get_dparent()) == visited.end())) {
-                node_component.insert(curr);
-                curr = curr->get_parent() ? curr->get_parent() : curr->get_head()->get_dparent();
-            }
-            node_component.insert(curr);
-            LinkCutNode* root = curr;
-            if (curr->get_parent() || curr->get_head()->get_dparent())
-                root = curr->get_parent() ? visited[curr->get_parent()] : visited[curr->get_head()->get_dparent()];
-
-            if (cc_map.find(root) == cc_map.end()) {
-                std::set<node_id_t> component;
-                cc_map.insert({root, component});
-            }
-			for (auto node : node_component) {
-				cc_map[root].insert(node-&nodes[0]);
-				visited.insert({node, root});
-			}
-		}
-	}
-    std::vector<std::set<node_id_t>> cc;
-    for (auto component : cc_map) {
-        cc.push_back(component.second);
+    ComponentLabels cc;
+    get_cc_labels(cc);
+    return cc.to_sets();
+}
+
+void LinkCutTree::get_cc_labels(ComponentLabels& cc, bool with_lists) {
+    constexpr node_id_t unlabeled = (node_id_t)-1;
+    cc.labels.assign(nodes.size(), unlabeled);
+    cc.num_components = 0;
+    std::vector<node_id_t> path;
+    for (node_id_t i = 0; i < nodes.size(); i++) {
+        // Walk up until reaching a labeled node or the root of the represented tree,
+        // so every node is walked over once in total
+        LinkCutNode* curr = &nodes[i];
+        while (cc.labels[curr-&nodes[0]] == unlabeled) {
+            path.push_back(curr-&nodes[0]);
+            LinkCutNode* up = curr->get_parent() ? curr->get_parent() : curr->get_head()->get_dparent();
+            if (!up) break;
+            curr = up;
+        }
+        node_id_t label = cc.labels[curr-&nodes[0]];
+        if (label == unlabeled)
+            label = cc.num_components++;
+        for (node_id_t v : path)
+            cc.labels[v] = label;
+        path.clear();
     }
-	return cc;
+    if (with_lists)
+        cc.build_lists();
 }
@@ -0,0 +1,50 @@
+#include <cassert>
+
+#include "sketch_pool.h"
+#include "skiplist.h"
+
+SketchPool::SketchPool(long seed, int buffer_cap) : seed(seed), buffer_cap(buffer_cap) {
+	assert(buffer_cap > 0);
+}
+
+SketchPool::~SketchPool() {
+	for (Sketch* sketch : sketches)
+		delete sketch;
+	for (vec_t* buffer : buffers)
+		delete[] buffer;
+}
+
+Sketch* SketchPool::acquire() {
+	if (free_sketches.empty()) {
+		sketches.push_back(new Sketch(sketch_len, seed, 1, sketch_err));
+		return sketches.back();
+	}
+	Sketch* sketch = free_sketches.back();
+	free_sketches.pop_back();
+	sketch->zero_contents();
+	return sketch;
+}
+
+void SketchPool::release(Sketch* sketch) {
+	free_sketches.push_back(sketch);
+}
+
+vec_t* SketchPool::acquire_buffer() {
+	if (free_buffers.empty()) {
+		buffers.push_back(new vec_t[buffer_cap]);
+		return buffers.back();
+	}
+	vec_t* buffer = free_buffers.back();
+	free_buffers.pop_back();
+	return buffer;
+}
+
+void SketchPool::release_buffer(vec_t* buffer) {
+	free_buffers.push_back(buffer);
+}
+
+void SketchPool::reset() {
+	// Sketches are zeroed when they are handed out again
+	free_sketches = sketches;
+	free_buffers = buffers;
+}
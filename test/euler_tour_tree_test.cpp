@@ -1,10 +1,14 @@
 #include <algorithm>
+#include <chrono>
 #include <cstdint>
+#include <random>
+#include <unordered_map>
 #include <unordered_set>
 
 #include <gtest/gtest.h>
 
 #include <euler_tour_tree.h>
+#include "util.h"
 
 bool EulerTourNode::isvalid() const {
   bool invalid = false;
@@ -14,30 +18,32 @@ bool EulerTourNode::isvalid() const {
   // make sure allowed_caller corresponds to one of the nodes
   bool allowed_valid = false;
   // validate each edge
-  for (const auto& [k, v] : this->edges) {
+  this->edges.for_each([&](SkipListNode* v) {
+    if (invalid) return;
     // validate node's back ptr
     EXPECT_EQ(v->node, this) << (invalid = true, "");
-    if (invalid) return false;
+    if (invalid) return;
     // validate node itself
     EXPECT_TRUE(v->isvalid()) << (invalid = true, "");
-    if (invalid) return false;
-    if (k == nullptr) {
+    if (invalid) return;
+    if (v == this->edges.find(nullptr)) {
       // node is sentinel, expect next to be null
       EXPECT_EQ(v->next(), nullptr) << (invalid = true, "");
-      if (invalid) return false;
+      if (invalid) return;
     } else {
-      // node is not sentinel, expect next to be valid
-      EXPECT_EQ(v->next()->node, k) << (invalid = true, "");
-      if (invalid) return false;
+      // node is not sentinel, expect next to be valid and indexed under it
+      EXPECT_EQ(this->edges.find(v->next()->node), v) << (invalid = true, "");
+      if (invalid) return;
     }
     // check allowed_caller
     if (v == allowed_caller) {
       // make sure there's only one allowed
       EXPECT_FALSE(allowed_valid) << (invalid = true, "");
-      if (invalid) return false;
+      if (invalid) return;
       allowed_valid = true;
     }
-  }
+  });
+  if (invalid) return false;
   // check that there was one allowed_caller
   EXPECT_TRUE(allowed_valid) << (invalid = true, "");
   if (invalid) return false;
@@ -47,16 +53,16 @@ bool EulerTourNode::isvalid() const {
 
 std::ostream& operator<<(std::ostream& os, const EulerTourNode& ett) {
   os << "EulerTourNode " << &ett << std::endl;
-  for (const auto& [k, v] : ett.edges) {
-    os << "to EulerTourNode " << k << " is " << &v << std::endl;
+  ett.edges.for_each([&](SkipListNode* v) {
+    os << "to EulerTourNode " << (v->next() ? v->next()->node : nullptr) << " is " << v << std::endl;
     os << v << std::endl;
-  }
+  });
   os << std::endl;
   return os;
 }
 
 std::ostream& operator<<(std::ostream& os,
-    const std::vector<EulerTourNode>& nodes) {
+    const EulerTourNodeArray& nodes) {
   for (const auto& node : nodes) {
     os << node;
   }
@@ -125,7 +131,7 @@ TEST(EulerTourTreeSuite, random_links_and_cuts) {
   std::unordered_set<SkipListNode*> sentinels;
   for (int i = 0; i < nodecount; i++)
   {
-    SkipListNode *sentinel = ett.ett_nodes[i].edges.begin()->second->get_last();
+    SkipListNode *sentinel = ett.ett_nodes[i].edges.any()->get_last();
     sentinels.insert(sentinel);
   }
 
@@ -134,7 +140,7 @@ TEST(EulerTourTreeSuite, random_links_and_cuts) {
   std::unordered_map<SkipListNode*, uint32_t> sizes;
   for (int i = 0; i < nodecount; i++)
   {
-    SkipListNode* sentinel = ett.ett_nodes[i].edges.begin()->second->get_last();
+    SkipListNode* sentinel = ett.ett_nodes[i].edges.any()->get_last();
     if (aggs.find(sentinel) == aggs.end())
     {
       Sketch* agg = new Sketch(sketch_len, seed, 1, sketch_err);
@@ -151,18 +157,19 @@ TEST(EulerTourTreeSuite, random_links_and_cuts) {
   // Naively compute aggregates for each connected component
   for (int i = 0; i < nodecount; i++)
   {
-    SkipListNode* sentinel = ett.ett_nodes[i].edges.begin()->second->get_last();
+    SkipListNode* sentinel = ett.ett_nodes[i].edges.any()->get_last();
     sentinel->process_updates();
+    ett.ett_nodes[i].allowed_caller->process_updates();
     if (naive_aggs.find(sentinel) != naive_aggs.end())
     {
-      naive_aggs[sentinel]->merge(*ett.ett_nodes[i].allowed_caller->sketch_agg);
+      naive_aggs[sentinel]->merge(*ett.ett_nodes[i].allowed_caller->get_sketch());
       naive_sizes[sentinel] += 1;
     }
     else
     {
       Sketch* agg = new Sketch(sketch_len, seed, 1, sketch_err);
       naive_aggs.insert({sentinel, agg});
-      naive_aggs[sentinel]->merge(*ett.ett_nodes[i].allowed_caller->sketch_agg);
+      naive_aggs[sentinel]->merge(*ett.ett_nodes[i].allowed_caller->get_sketch());
       naive_sizes[sentinel] = 1;
     }
   }
@@ -208,3 +215,370 @@ TEST(EulerTourTreeSuite, get_aggregate) {
   Sketch* aggregate = ett.get_aggregate(0);
   ASSERT_TRUE(*aggregate == true_aggregate);
 }
+
+TEST(EulerTourTreeSuite, slab_reuse_test) {
+  // Sketch variables
+  sketch_len = 1000;
+  sketch_err = 100;
+
+  int nodecount = 1000;
+  int seed = time(NULL);
+  srand(seed);
+  std::cout << "Seeding slab reuse test with " << seed << std::endl;
+  EulerTourTree ett(nodecount, 0, seed);
+  SkipListAllocator* allocator = ett.ett_nodes[0].get_allocator();
+
+  // Repeatedly link everything into a path and cut it back into singletons.
+  // Freed skiplist nodes should be reused, so the slab memory reserved after
+  // many rounds stays close to what the first round needed.
+  size_t first_round_bytes = 0;
+  for (int round = 0; round < 10; round++) {
+    for (int i = 0; i < nodecount-1; i++)
+      ett.link(i, i+1);
+    for (int i = 0; i < nodecount-1; i++)
+      ett.cut(i, i+1);
+    if (round == 0) first_round_bytes = allocator->reserved_bytes();
+  }
+  if (use_slab_allocator) {
+    ASSERT_LT(allocator->reserved_bytes(), 2*first_round_bytes);
+  }
+  ASSERT_TRUE(std::all_of(ett.ett_nodes.begin(), ett.ett_nodes.end(),
+        [](auto& node){return node.isvalid();}));
+}
+
+TEST(EulerTourTreeSuite, sketch_pool_test) {
+  // Sketch variables
+  sketch_len = 1000;
+  sketch_err = 100;
+
+  int nodecount = 200;
+  int seed = time(NULL);
+  srand(seed);
+  std::cout << "Seeding sketch pool test with " << seed << std::endl;
+  EulerTourTree ett(nodecount, 0, seed);
+  SketchPool* sketch_pool = ett.ett_nodes[0].get_sketch_pool();
+  for (int i = 0; i < nodecount; i++)
+    ett.update_sketch(i, (vec_t)i);
+
+  // After the first round, later rounds of the same links and cuts should
+  // borrow every sketch they need from the pool instead of the heap
+  size_t allocated = 0;
+  for (int round = 0; round < 5; round++) {
+    for (int i = 0; i < nodecount-1; i++)
+      ett.link(i, i+1);
+    for (int i = 0; i < nodecount-1; i++)
+      ett.cut(i, i+1);
+    if (round == 0) allocated = sketch_pool->num_allocated();
+    ASSERT_EQ(sketch_pool->num_allocated(), allocated) << "Sketches allocated in round " << round;
+  }
+}
+
+TEST(EulerTourTreeSuite, memory_test) {
+  // Sketch variables
+  sketch_len = 1000;
+  sketch_err = 100;
+
+  int nodecount = 10000;
+  int seed = time(NULL);
+  double prev_height_factor = height_factor;
+  height_factor = 1./log2(log2(nodecount));
+  EulerTourTree ett(nodecount, 0, seed);
+  for (int i = 0; i < nodecount; i++)
+    ett.update_sketch(i, (vec_t)i);
+  for (int i = 0; i < nodecount-1; i++)
+    ett.link(i, i+1);
+  height_factor = prev_height_factor;
+
+  // Skiplist node and update buffer memory, sketches are not included
+  SketchPool* sketch_pool = ett.ett_nodes[0].get_sketch_pool();
+  size_t node_bytes = ett.ett_nodes[0].get_allocator()->reserved_bytes();
+  size_t buffer_bytes = sketch_pool->num_buffers_in_use()*sketch_pool->get_buffer_cap()*sizeof(vec_t);
+  std::cout << "sizeof(SkipListNode): " << sizeof(SkipListNode) << std::endl;
+  std::cout << "Skiplist bytes per ETT element: " << node_bytes/nodecount << std::endl;
+  std::cout << "Update buffer bytes per ETT element: " << buffer_bytes/nodecount << std::endl;
+  std::cout << "Total bytes per ETT element: " << (node_bytes+buffer_bytes)/nodecount << std::endl;
+}
+
+TEST(EulerTourTreeSuite, update_sketches_batch_test) {
+  // Sketch variables
+  sketch_len = 1000*1000;
+  sketch_err = 4;
+
+  int nodecount = 1000;
+  int seed = time(NULL);
+  srand(seed);
+  std::cout << "Seeding batch update test with " << seed << std::endl;
+  EulerTourTree ett(nodecount, 0, seed);
+  EulerTourTree batch_ett(nodecount, 0, seed);
+  for (int i = 0; i < nodecount; i++) {
+    int a = rand() % nodecount, b = rand() % nodecount;
+    ett.link(a, b);
+    batch_ett.link(a, b);
+  }
+
+  uint32_t batch_size = 1000;
+  std::vector<GraphUpdate> updates(batch_size);
+  std::vector<BatchRoot> roots(2*batch_size);
+  for (int batch = 0; batch < 5; batch++) {
+    for (uint32_t i = 0; i < batch_size; i++) {
+      node_id_t a = rand() % nodecount, b = rand() % nodecount;
+      updates[i] = {{std::min(a, b), std::max(a, b)}, INSERT};
+    }
+    batch_ett.update_sketches_batch(updates.data(), batch_size, roots.data());
+    for (uint32_t i = 0; i < batch_size; i++) {
+      Edge e = updates[i].edge;
+      auto expected = ett.update_sketches(e.src, e.dst, (vec_t)VERTICES_TO_EDGE(e.src, e.dst));
+      ASSERT_EQ(roots[2*i].size, expected.first->size);
+      ASSERT_EQ(roots[2*i+1].size, expected.second->size);
+      ASSERT_EQ(roots[2*i].sample, expected.first->sample_agg().result) << "Update " << i;
+      ASSERT_EQ(roots[2*i+1].sample, expected.second->sample_agg().result) << "Update " << i;
+    }
+    // Cutting exposes the aggregates below the roots as well
+    for (int i = 0; i < 100; i++) {
+      int a = rand() % nodecount, b = rand() % nodecount;
+      ett.cut(a, b);
+      batch_ett.cut(a, b);
+    }
+    for (int v = 0; v < nodecount; v++) {
+      ett.get_root(v)->process_updates();
+      ASSERT_TRUE(*ett.get_aggregate(v) == *batch_ett.get_aggregate(v)) << "Vertex " << v;
+    }
+  }
+}
+
+TEST(EulerTourTreeSuite, update_sketches_batch_speed_test) {
+  // Compare a batch against the same updates one at a time on a few large trees
+  int nodecount = 100000;
+  uint32_t batch_size = 1000;
+  int num_batches = 100;
+  double prev_height_factor = height_factor;
+  height_factor = 1./log2(log2(nodecount));
+  sketch_len = Sketch::calc_vector_length(nodecount);
+  sketch_err = 4;
+  int seed = time(NULL);
+  std::cout << "Seeding batch update speed test with " << seed << std::endl;
+  std::mt19937_64 rng(seed);
+  EulerTourTree ett(nodecount, 0, seed);
+  EulerTourTree batch_ett(nodecount, 0, seed);
+  for (int v = 1; v < nodecount; v++) {
+    if (v % (nodecount/8) == 0) continue;
+    int u = rng() % v;
+    ett.link(u, v);
+    batch_ett.link(u, v);
+  }
+  std::vector<GraphUpdate> updates(batch_size);
+  std::vector<BatchRoot> roots(2*batch_size);
+  std::chrono::nanoseconds batch_time{}, single_time{};
+  for (int batch = 0; batch < num_batches; batch++) {
+    for (uint32_t i = 0; i < batch_size; i++) {
+      node_id_t a = rng() % nodecount, b = rng() % (nodecount-1);
+      if (b >= a) b++;
+      updates[i] = {{std::min(a, b), std::max(a, b)}, INSERT};
+    }
+    auto start = std::chrono::high_resolution_clock::now();
+    batch_ett.update_sketches_batch(updates.data(), batch_size, roots.data());
+    auto mid = std::chrono::high_resolution_clock::now();
+    for (uint32_t i = 0; i < batch_size; i++) {
+      Edge e = updates[i].edge;
+      auto update_roots = ett.update_sketches(e.src, e.dst, (vec_t)VERTICES_TO_EDGE(e.src, e.dst));
+      update_roots.first->sample_agg();
+      update_roots.second->sample_agg();
+    }
+    batch_time += mid - start;
+    single_time += std::chrono::high_resolution_clock::now() - mid;
+  }
+  std::cout << "update_sketches_batch (ms): " << batch_time.count()/1000000 << std::endl;
+  std::cout << "update_sketches one at a time (ms): " << single_time.count()/1000000 << std::endl;
+  height_factor = prev_height_factor;
+}
+
+TEST(EulerTourTreeSuite, edge_index_test) {
+  struct Vertex { node_id_t vertex; };
+  int nodecount = 200;
+  std::vector<Vertex> vertices(nodecount);
+  std::vector<int> occurrences(nodecount);
+  for (int i = 0; i < nodecount; i++)
+    vertices[i].vertex = i;
+  int sentinel = -1;
+
+  EdgeIndex<Vertex, int> edges;
+  ASSERT_TRUE(edges.empty());
+  edges.insert(nullptr, &sentinel);
+  ASSERT_EQ(edges.any(), &sentinel);
+  // Grow through the inline arrays into ever larger tables
+  for (int i = 0; i < nodecount; i++) {
+    ASSERT_EQ(edges.insert(&vertices[i], &occurrences[i]), &occurrences[i]);
+    ASSERT_EQ(edges.insert(&vertices[i], &sentinel), &occurrences[i]);
+    ASSERT_EQ(edges.size(), (size_t)i+2);
+  }
+  EdgeIndex<Vertex, int> copy(edges);
+  // Shrink back down to the inline arrays, checking every remaining edge on the way
+  for (int i = nodecount-1; i >= 0; i--) {
+    edges.erase(&vertices[i]);
+    ASSERT_EQ(edges.find(&vertices[i]), nullptr);
+    if (i % 16 == 0 || i < 8) {
+      for (int j = 0; j < i; j++)
+        ASSERT_EQ(edges.find(&vertices[j]), &occurrences[j]);
+    }
+  }
+  ASSERT_EQ(edges.size(), (size_t)1);
+  edges.erase(nullptr);
+  ASSERT_TRUE(edges.empty());
+
+  EdgeIndex<Vertex, int> moved(std::move(copy));
+  size_t visited = 0;
+  moved.for_each([&](int* occurrence) {
+    visited++;
+    ASSERT_TRUE(occurrence == &sentinel || moved.find(&vertices[occurrence-occurrences.data()]) == occurrence);
+  });
+  ASSERT_EQ(visited, (size_t)nodecount+1);
+}
+
+TEST(EulerTourTreeSuite, sample_cache_test) {
+  // global sketch variables
+  sketch_len = 1000;
+  sketch_err = 100;
+
+  int nodecount = 200;
+  int seed = time(NULL);
+  srand(seed);
+  std::cout << "Seeding sample cache test with " << seed << std::endl;
+  EulerTourTree ett(nodecount, 0, seed);
+  for (int i = 0; i < 10000; i++) {
+    node_id_t a = rand() % nodecount, b = rand() % nodecount;
+    if (a == b) continue;
+    int op = rand() % 4;
+    if (op == 0) ett.link(a, b);
+    else if (op == 1) ett.cut(a, b);
+    else ett.update_sketches(a, b, (vec_t)VERTICES_TO_EDGE(std::min(a, b), std::max(a, b)));
+    // The possibly cached sample of the root must match sampling its aggregate from scratch
+    SkipListNode* root = ett.get_root(a);
+    SketchSample sample = root->sample_agg();
+    root->sample_dirty = true;
+    SketchSample expected = root->sample_agg();
+    ASSERT_EQ(sample.result, expected.result) << "Step " << i;
+    if (expected.result == GOOD) {
+      ASSERT_EQ(sample.idx, expected.idx) << "Step " << i;
+    }
+  }
+}
+
+TEST(EulerTourTreeSuite, exact_aggregate_test) {
+  // global sketch variables
+  sketch_len = 1000;
+  sketch_err = 100;
+
+  int nodecount = 1000;
+  int group_size = 4;
+  int seed = time(NULL);
+  srand(seed);
+  std::cout << "Seeding exact aggregate test with " << seed << std::endl;
+  EulerTourTree ett(nodecount, 0, seed);
+  SketchPool* sketch_pool = ett.ett_nodes[0].get_sketch_pool();
+  auto sketches_in_use = [&]() {return sketch_pool->num_allocated() - sketch_pool->num_free();};
+  // Every edge id in the aggregate of each vertex
+  std::vector<std::set<vec_t>> incident(nodecount);
+  for (node_id_t a = 0; a < (node_id_t)nodecount/2; a++) {
+    node_id_t b = a + nodecount/2;
+    vec_t update_idx = VERTICES_TO_EDGE(a, b);
+    ett.update_sketches(a, b, update_idx);
+    incident[a].insert(update_idx);
+    incident[b].insert(update_idx);
+  }
+  auto check_samples = [&]() {
+    ComponentLabels cc;
+    ett.get_cc_labels(cc);
+    std::vector<std::set<vec_t>> cut_edges(cc.num_components);
+    for (int v = 0; v < nodecount; v++) {
+      for (vec_t update_idx : incident[v]) {
+        if (!cut_edges[cc.labels[v]].erase(update_idx)) cut_edges[cc.labels[v]].insert(update_idx);
+      }
+    }
+    for (int v = 0; v < nodecount; v++) {
+      std::set<vec_t>& expected = cut_edges[cc.labels[v]];
+      SketchSample sample = ett.get_root(v)->sample_agg();
+      if (expected.empty()) {
+        ASSERT_EQ(sample.result, ZERO) << "Vertex " << v;
+      } else {
+        ASSERT_NE(sample.result, ZERO) << "Vertex " << v;
+        if (sample.result == GOOD) {
+          ASSERT_TRUE(expected.count(sample.idx)) << "Vertex " << v;
+        }
+      }
+    }
+  };
+
+  // Small components never need a sketch
+  for (int i = 0; i < nodecount; i++) {
+    if (i % group_size != 0) ett.link(i-1, i);
+  }
+  check_samples();
+  ASSERT_EQ(sketches_in_use(), (size_t)0);
+
+  // Joining them all overflows the update buffers on the way up
+  for (int i = group_size; i < nodecount; i += group_size)
+    ett.link(i-group_size, i);
+  check_samples();
+  ASSERT_GT(sketches_in_use(), (size_t)0);
+
+  // Splitting them apart again gives every aggregate back its exact form
+  std::vector<int> order;
+  for (int i = group_size; i < nodecount; i += group_size)
+    order.push_back(i);
+  std::shuffle(order.begin(), order.end(), std::mt19937(seed));
+  for (int i : order)
+    ett.cut(i-group_size, i);
+  check_samples();
+  ASSERT_EQ(sketches_in_use(), (size_t)0);
+}
+
+TEST(EulerTourTreeSuite, reset_test) {
+  // global sketch variables
+  sketch_len = 1000;
+  sketch_err = 100;
+
+  int nodecount = 1000;
+  int seed = time(NULL);
+  std::cout << "Seeding reset test with " << seed << std::endl;
+  EulerTourTree ett(nodecount, 0, seed);
+  SkipListAllocator* allocator = ett.ett_nodes[0].get_allocator();
+  SketchPool* sketch_pool = ett.ett_nodes[0].get_sketch_pool();
+  auto build = [&](EulerTourTree& tree) {
+    srand(seed);
+    for (int i = 0; i < nodecount; i++) {
+      node_id_t a = rand() % nodecount, b = rand() % nodecount;
+      tree.link(a, b);
+      tree.update_sketches(a, b, (vec_t)VERTICES_TO_EDGE(std::min(a, b), std::max(a, b)));
+    }
+  };
+
+  // Every round builds the same forest, which after a reset needs no new memory
+  // and ends up the same as building it in a new tree
+  size_t reset_bytes = 0;
+  size_t reset_sketches = 0;
+  for (int round = 0; round < 5; round++) {
+    build(ett);
+    if (round > 0) {
+      ASSERT_EQ(allocator->reserved_bytes(), reset_bytes) << "Round " << round;
+      ASSERT_EQ(sketch_pool->num_allocated(), reset_sketches) << "Round " << round;
+      EulerTourTree fresh(nodecount, 0, seed);
+      build(fresh);
+      for (int v = 0; v < nodecount; v++) {
+        ASSERT_EQ(ett.get_size(v), fresh.get_size(v)) << "Vertex " << v;
+        ASSERT_TRUE(*ett.get_aggregate(v) == *fresh.get_aggregate(v)) << "Vertex " << v;
+      }
+    }
+    ASSERT_TRUE(std::all_of(ett.ett_nodes.begin(), ett.ett_nodes.end(),
+          [](auto& node){return node.isvalid();}));
+
+    reset_bytes = allocator->reserved_bytes();
+    reset_sketches = sketch_pool->num_allocated();
+    ett.reset();
+    for (int v = 0; v < nodecount; v++) {
+      ASSERT_EQ(ett.get_size(v), (uint32_t)2) << "Vertex " << v;
+      ASSERT_EQ(ett.get_root(v)->sample_agg().result, ZERO) << "Vertex " << v;
+    }
+    ASSERT_TRUE(std::all_of(ett.ett_nodes.begin(), ett.ett_nodes.end(),
+          [](auto& node){return node.isvalid();}));
+  }
+}
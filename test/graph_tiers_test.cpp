@@ -42,6 +42,7 @@ TEST(GraphTiersSuite, mini_correctness_test) {
         gt.update({{i, i+1}, INSERT});
         gv.edge_update(i,i+1);
         std::vector<std::set<node_id_t>> cc = gt.get_cc();
+        ASSERT_EQ(gt.num_components(), cc.size());
         try {
             gv.reset_cc_state();
             gv.verify_soln(cc);
@@ -56,6 +57,7 @@ TEST(GraphTiersSuite, mini_correctness_test) {
         gt.update({{i, i+1}, DELETE});
         gv.edge_update(i,i+1);
         std::vector<std::set<node_id_t>> cc = gt.get_cc();
+        ASSERT_EQ(gt.num_components(), cc.size());
         try {
             gv.reset_cc_state();
             gv.verify_soln(cc);
@@ -67,6 +69,94 @@ TEST(GraphTiersSuite, mini_correctness_test) {
     }
 }
 
+TEST(GraphTiersSuite, cc_labels_test) {
+    node_id_t numnodes = 100;
+    sketch_len = Sketch::calc_vector_length(numnodes);
+    sketch_err = DEFAULT_SKETCH_ERR;
+    GraphTiers gt(numnodes);
+    MatGraphVerifier gv(numnodes);
+    std::set<std::pair<node_id_t, node_id_t>> edges;
+    int seed = time(NULL);
+    srand(seed);
+    std::cout << "Seeding cc labels test with " << seed << std::endl;
+
+    ComponentLabels cc;
+    ComponentLabels lct_cc;
+    for (int round = 0; round < 20; round++) {
+        // Insert or delete a few random edges between queries
+        for (int i = 0; i < 20; i++) {
+            node_id_t a = rand() % numnodes, b = rand() % numnodes;
+            if (a == b) continue;
+            std::pair<node_id_t, node_id_t> e = {std::min(a, b), std::max(a, b)};
+            bool present = edges.count(e);
+            gt.update({{e.first, e.second}, present ? DELETE : INSERT});
+            gv.edge_update(e.first, e.second);
+            if (present) edges.erase(e); else edges.insert(e);
+        }
+        gt.get_cc_labels(cc, true);
+        gt.link_cut_tree.get_cc_labels(lct_cc, true);
+        ASSERT_EQ(cc.labels.size(), numnodes);
+        ASSERT_EQ(cc.num_components, lct_cc.num_components);
+        // Both labelings have to group the vertices the same way
+        for (node_id_t v = 0; v < numnodes; v++)
+            for (node_id_t u = 0; u < v; u++)
+                ASSERT_EQ(cc.labels[u] == cc.labels[v], lct_cc.labels[u] == lct_cc.labels[v]);
+        // The lists have to hold exactly the vertices with each label
+        ASSERT_EQ(cc.offsets.size(), cc.num_components+1);
+        ASSERT_EQ(cc.offsets.back(), numnodes);
+        for (node_id_t c = 0; c < cc.num_components; c++) {
+            ASSERT_LT(cc.offsets[c], cc.offsets[c+1]);
+            for (node_id_t i = cc.offsets[c]; i < cc.offsets[c+1]; i++)
+                ASSERT_EQ(cc.labels[cc.vertices[i]], c);
+        }
+        std::vector<std::set<node_id_t>> cc_sets = cc.to_sets();
+        try {
+            gv.reset_cc_state();
+            gv.verify_soln(cc_sets);
+        } catch (IncorrectCCException& e) {
+            std::cout << "Incorrect cc labels found in round " << round << std::endl;
+            FAIL();
+        }
+    }
+}
+
+TEST(GraphTiersSuite, reset_test) {
+    node_id_t numnodes = 100;
+    sketch_len = Sketch::calc_vector_length(numnodes);
+    sketch_err = DEFAULT_SKETCH_ERR;
+    GraphTiers gt(numnodes);
+    int seed = time(NULL);
+    srand(seed);
+    std::cout << "Seeding reset test with " << seed << std::endl;
+
+    // Each round starts over from an empty graph on the same tiers
+    for (int round = 0; round < 5; round++) {
+        MatGraphVerifier gv(numnodes);
+        std::set<std::pair<node_id_t, node_id_t>> edges;
+        for (int i = 0; i < 500; i++) {
+            node_id_t a = rand() % numnodes, b = rand() % numnodes;
+            if (a == b) continue;
+            std::pair<node_id_t, node_id_t> e = {std::min(a, b), std::max(a, b)};
+            bool present = edges.count(e);
+            gt.update({{e.first, e.second}, present ? DELETE : INSERT});
+            gv.edge_update(e.first, e.second);
+            if (present) edges.erase(e); else edges.insert(e);
+        }
+        std::vector<std::set<node_id_t>> cc = gt.get_cc();
+        ASSERT_EQ(gt.num_components(), cc.size());
+        try {
+            gv.reset_cc_state();
+            gv.verify_soln(cc);
+        } catch (IncorrectCCException& e) {
+            std::cout << "Incorrect cc found in round " << round << std::endl;
+            FAIL();
+        }
+        gt.reset();
+        ASSERT_EQ(gt.get_cc().size(), numnodes) << "Round " << round;
+        ASSERT_EQ(gt.num_components(), numnodes) << "Round " << round;
+    }
+}
+
 TEST(GraphTiersSuite, deletion_replace_correctness_test) {
     node_id_t numnodes = 50;
     GraphTiers gt(numnodes);
@@ -192,6 +282,82 @@ TEST(GraphTiersSuite, omp_speed_test) {
     }
 }
 
+TEST(GraphTiersSuite, omp_allocator_speed_test) {
+    omp_set_dynamic(1);
+    try {
+        // Run the same prefix of the stream with heap allocated and slab allocated skiplist nodes
+        for (bool slab : {false, true}) {
+            use_slab_allocator = slab;
+            BinaryGraphStream stream(stream_file, 100000);
+
+            height_factor = 1./log2(log2(stream.nodes()));
+            sketch_len = Sketch::calc_vector_length(stream.nodes());
+            sketch_err = DEFAULT_SKETCH_ERR;
+
+            GraphTiers gt(stream.nodes());
+            int edgecount = std::min(stream.edges(), (edge_id_t)1000000);
+
+            auto start = std::chrono::high_resolution_clock::now();
+            for (int i = 0; i < edgecount; i++) {
+                GraphUpdate update = stream.get_edge();
+                gt.update(update);
+            }
+            auto stop = std::chrono::high_resolution_clock::now();
+            auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(stop - start);
+            std::cout << (slab ? "Slab" : "Heap") << " allocator, " << edgecount << " updates, Time: " << duration.count() << std::endl;
+        }
+    } catch (BadStreamException& e) {
+        std::cout << "ERROR: Stream binary file not found." << std::endl;
+    }
+    // Later tests expect the default, even if the stream could not be read
+    use_slab_allocator = true;
+}
+
+TEST(GraphTiersSuite, omp_path_length_test) {
+    omp_set_dynamic(1);
+    try {
+        BinaryGraphStream stream(stream_file, 100000);
+
+        height_factor = 1./log2(log2(stream.nodes()));
+        sketch_len = Sketch::calc_vector_length(stream.nodes());
+        sketch_err = DEFAULT_SKETCH_ERR;
+
+        GraphTiers gt(stream.nodes());
+        int edgecount = std::min(stream.edges(), (edge_id_t)1000000);
+
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int i = 0; i < edgecount; i++) {
+            GraphUpdate update = stream.get_edge();
+            gt.update(update);
+        }
+        auto stop = std::chrono::high_resolution_clock::now();
+        auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(stop - start);
+
+        // Walk from every allowed caller in every tier to its root
+        long total_path_length = 0;
+        long total_caller_height = 0;
+        long num_callers = 0;
+        for (EulerTourTree& tier : gt.ett) {
+            for (EulerTourNode& ett_node : tier.ett_nodes) {
+                total_caller_height += ett_node.allowed_caller->get_height();
+                for (SkipListNode* curr = ett_node.allowed_caller; curr->get_parent(); curr = curr->get_parent())
+                    total_path_length++;
+                num_callers++;
+            }
+        }
+        double avg_path_length = (double)total_path_length/num_callers;
+        double avg_caller_height = (double)total_caller_height/num_callers;
+        double throughput = edgecount/std::max(duration.count()/1000., 0.001);
+        std::cout << stream_file << ": " << edgecount << " updates, Time: " << duration.count()
+            << ", Updates/second: " << throughput << std::endl;
+        std::cout << "Average root path length: " << avg_path_length
+            << ", Average allowed caller height: " << avg_caller_height << std::endl;
+
+    } catch (BadStreamException& e) {
+        std::cout << "ERROR: Stream binary file not found." << std::endl;
+    }
+}
+
 TEST(GraphTiersSuite, query_speed_test) {
     omp_set_dynamic(1);
     try {
@@ -224,8 +390,9 @@ TEST(GraphTiersSuite, query_speed_test) {
         auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(stop - start);
         std::cout << querycount << " Connectivity Queries, Time:  " << duration.count() << std::endl;
         start = std::chrono::high_resolution_clock::now();
+        ComponentLabels cc;
         for (int i = 0; i < querycount/100; i++) {
-            gt.get_cc();
+            gt.get_cc_labels(cc);
         }
         stop = std::chrono::high_resolution_clock::now();
         duration = std::chrono::duration_cast<std::chrono::milliseconds>(stop - start);
@@ -1,5 +1,7 @@
 #include <gtest/gtest.h>
+#include <chrono>
 #include <iostream>
+#include <random>
 #include <string>
 #include "link_cut_tree.h"
 
@@ -84,7 +86,7 @@ TEST(LinkCutTreeSuite, join_split_test) {
             lct.nodes[j].splay();
             lct.nodes[j+i/2].splay();
             //std::cout << "Join nodes: " << &nodes[j] << " and " << &nodes[j+i/2] << "\n";
-            LinkCutNode* p = lct.join(&lct.nodes[j], &lct.nodes[j+i/2]);
+            LinkCutNode* p = lct.join(&lct.nodes[j], &lct.nodes[j+i/2], 0);
             EXPECT_EQ(p->get_head(), &lct.nodes[j]);
             EXPECT_EQ(p->get_tail(), &lct.nodes[j+i-1]);
         }
@@ -118,12 +120,12 @@ TEST(LinkCutTreeSuite, expose_simple_test) {
     for (int path = 0; path < pathcount; path++) {
         for (int node = 0; node < nodesperpath-1; node++) {
             lct.nodes[path*nodesperpath+node].splay();
-            lct.join(&lct.nodes[path*nodesperpath+node], &lct.nodes[path*nodesperpath+node+1]);
+            lct.join(&lct.nodes[path*nodesperpath+node], &lct.nodes[path*nodesperpath+node+1], 0);
         }
     }
     // Link all the paths together with dparent pointers half way up the previous path
     for (int path = 1; path < pathcount; path++) {
-        lct.nodes[path*nodesperpath].set_dparent(&lct.nodes[path*nodesperpath-nodesperpath/2]);
+        lct.nodes[path*nodesperpath].set_dparent(&lct.nodes[path*nodesperpath-nodesperpath/2], 0);
     }
     // Call expose on the node half way up the bottom path
     LinkCutNode* p = lct.expose(&lct.nodes[pathcount*nodesperpath-nodesperpath/2]);
@@ -151,6 +153,7 @@ TEST(LinkCutTreeSuite, random_links_and_cuts) {
         ASSERT_TRUE(std::all_of(lct.nodes.begin(), lct.nodes.end(), [](auto& node){return validate(&node);}))
           << "One or more invalid nodes found" << std::endl;
     }
+    ASSERT_EQ(lct.get_num_trees(), 1);
     // Cut every node
     for (int i = 0; i < nodecount-1; i+=1) {
         lct.cut(i,i+1);
@@ -161,6 +164,7 @@ TEST(LinkCutTreeSuite, random_links_and_cuts) {
     int n = 5000;
     std::cout << "Seeding random links and cuts test with " << seed << std::endl;
     srand(seed);
+    std::map<edge_id_t, uint32_t> edge_weights;
     for (int i = 0; i < n; i++) {
         node_id_t a = rand() % nodecount, b = rand() % nodecount;
         if (a != b) {
@@ -168,21 +172,38 @@ TEST(LinkCutTreeSuite, random_links_and_cuts) {
                 uint32_t weight = rand()%100;
                 //std::cout << i << ": Linking " << a << " and " << b << " weight " << weight << std::endl;
                 lct.link(a, b, weight);
+                edge_weights[VERTICES_TO_EDGE(a, b)] = weight;
                 //print_paths(&lct.nodes);
-            } else if (lct.nodes[a].edges.find(&lct.nodes[b]-&lct.nodes[0]) != lct.nodes[a].edges.end()) {
+            } else if (lct.has_edge(a, b)) {
                 //std::cout << i << ": Cutting " << a << " and " << b << std::endl;
                 lct.cut(a, b);
+                edge_weights.erase(VERTICES_TO_EDGE(a, b));
                 //print_paths(&lct.nodes);
             }
             ASSERT_TRUE(std::all_of(lct.nodes.begin(), lct.nodes.end(), [](auto& node){return validate(&node);}))
              << "One or more invalid nodes found" << std::endl;
         }
     }
+    ASSERT_EQ(lct.get_num_trees(), lct.get_cc().size());
+    // The edges are found from the paths alone, compare them with the ones that were linked
+    for (auto& edge : edge_weights) {
+        node_id_t a = edge.first >> 32, b = (node_id_t)edge.first;
+        ASSERT_TRUE(lct.has_edge(a, b) && lct.has_edge(b, a));
+        ASSERT_EQ(lct.get_edge_weight(b, a), edge.second);
+    }
+    for (int i = 0; i < n; i++) {
+        node_id_t a = rand() % nodecount, b = rand() % nodecount;
+        if (a != b) {
+            ASSERT_EQ(lct.has_edge(a, b), edge_weights.count(VERTICES_TO_EDGE(a, b)) > 0);
+        }
+    }
     // Manually compute the aggregates for each aux tree
     std::map<LinkCutNode*, uint32_t> path_aggregates;
     for (int i = 0; i < nodecount; i++) {
-        uint32_t nodemax = std::max(lct.nodes[i].edges[lct.nodes[i].preferred_edges.first],
-                lct.nodes[i].edges[lct.nodes[i].preferred_edges.second]);
+        uint32_t nodemax = 0;
+        for (auto& preferred : lct.nodes[i].preferred_edges)
+            if (preferred.neighbor != LinkCutNode::nil && lct.has_edge(i, preferred.neighbor))
+                nodemax = std::max(nodemax, lct.get_edge_weight(i, preferred.neighbor));
         LinkCutNode* curr = &lct.nodes[i];
         while (curr) {
             if (curr->get_parent() == nullptr) {
@@ -199,4 +220,127 @@ TEST(LinkCutTreeSuite, random_links_and_cuts) {
     for (auto agg : path_aggregates) {
         EXPECT_EQ(agg.second, agg.first->max) << "Aggregate incorrect" << std::endl;
     }
+    // Compare the head and tail of every aux tree with walking down to them
+    for (auto agg : path_aggregates) {
+        LinkCutNode* ends[2];
+        for (bool to_tail : {false, true}) {
+            bool reversal_state = false;
+            for (LinkCutNode* curr = agg.first; curr;) {
+                reversal_state = reversal_state != curr->get_reversed();
+                ends[to_tail] = curr;
+                curr = (reversal_state != to_tail) ? curr->get_right() : curr->get_left();
+            }
+        }
+        EXPECT_EQ(agg.first->get_head(), ends[0]) << "Head incorrect" << std::endl;
+        EXPECT_EQ(agg.first->get_tail(), ends[1]) << "Tail incorrect" << std::endl;
+    }
+}
+
+TEST(LinkCutTreeSuite, high_degree_test) {
+    // A star, where has_edge and get_edge_weight of the center are recovered from its preferred and dparent edges
+    int nodecount = 100;
+    LinkCutTree lct(nodecount);
+    for (int i = 1; i < nodecount; i++)
+        lct.link(0, i, i);
+    for (int i = 1; i < nodecount; i++) {
+        ASSERT_TRUE(lct.has_edge(0, i));
+        ASSERT_EQ(lct.get_edge_weight(i, 0), (uint32_t)i);
+    }
+    ASSERT_EQ(lct.path_aggregate(3, 7).second, 7);
+    // Cut every other leaf, the rest keep their weights
+    for (int i = 1; i < nodecount; i += 2)
+        lct.cut(0, i);
+    for (int i = 1; i < nodecount; i++)
+        ASSERT_EQ(lct.has_edge(i, 0), i % 2 == 0);
+    ASSERT_EQ(lct.path_aggregate(nodecount-2, 2).second, (uint32_t)nodecount-2);
+    ASSERT_EQ(lct.get_num_trees(), nodecount/2 + 1);
+}
+
+TEST(LinkCutTreeSuite, cycle_query_test) {
+    int nodecount = 1000;
+    LinkCutTree lct(nodecount);
+    int seed = time(NULL);
+    std::cout << "Seeding cycle query test with " << seed << std::endl;
+    srand(seed);
+    for (int i = 0; i < 20000; i++) {
+        node_id_t a = rand() % nodecount, b = rand() % nodecount;
+        bool connected = lct.find_root(a) == lct.find_root(b);
+        LinkCutTree::CycleQueryResult cycle = lct.cycle_query(a, b);
+        ASSERT_EQ(cycle.connected, connected);
+        if (!connected) {
+            // Weights start at 1 like tiers do, since the maximum of only zero weights has no edge
+            lct.link(a, b, rand() % 100 + 1);
+            continue;
+        }
+        std::pair<edge_id_t, uint32_t> max = lct.path_aggregate(a, b);
+        ASSERT_EQ(cycle.max_weight, max.second);
+        // Cut the maximum edge found by the cycle query, as a refresh would
+        if (a != b && rand() % 2) {
+            ASSERT_TRUE(lct.has_edge((node_id_t)cycle.max_edge, (node_id_t)(cycle.max_edge>>32)));
+            ASSERT_EQ(lct.get_edge_weight((node_id_t)cycle.max_edge, (node_id_t)(cycle.max_edge>>32)), cycle.max_weight);
+            lct.cut((node_id_t)cycle.max_edge, (node_id_t)(cycle.max_edge>>32));
+        }
+    }
+}
+
+TEST(LinkCutTreeSuite, speed_test) {
+    // Time each operation separately on a random forest
+    node_id_t nodecount = 100000;
+    int num_steps = 500000;
+    int seed = time(NULL);
+    std::cout << "Seeding link cut tree speed test with " << seed << std::endl;
+    std::cout << "sizeof(LinkCutNode): " << sizeof(LinkCutNode) << std::endl;
+    std::mt19937_64 rng(seed);
+    LinkCutTree lct(nodecount);
+    std::vector<std::pair<node_id_t, node_id_t>> edges;
+    long counts[4] = {0, 0, 0, 0};
+    std::chrono::nanoseconds times[4] = {};
+    uint64_t checksum = 0;
+    auto timed = [&](int op, auto&& f) {
+        auto start = std::chrono::high_resolution_clock::now();
+        f();
+        times[op] += std::chrono::high_resolution_clock::now() - start;
+        counts[op]++;
+    };
+    for (int i = 0; i < num_steps; i++) {
+        node_id_t a = rng() % nodecount, b = rng() % nodecount;
+        void* root_a;
+        void* root_b;
+        timed(2, [&]{ root_a = lct.find_root(a); });
+        timed(2, [&]{ root_b = lct.find_root(b); });
+        if (a == b) continue;
+        if (root_a != root_b) {
+            timed(0, [&]{ lct.link(a, b, rng() % 1000); });
+            edges.push_back({a, b});
+        } else {
+            timed(3, [&]{ checksum += lct.path_aggregate(a, b).second; });
+            if (rng() % 2) {
+                size_t e = rng() % edges.size();
+                timed(1, [&]{ lct.cut(edges[e].first, edges[e].second); });
+                edges[e] = edges.back();
+                edges.pop_back();
+            }
+        }
+    }
+    ASSERT_EQ(lct.get_num_trees(), nodecount - edges.size());
+    std::string names[4] = {"link", "cut", "find_root", "path_aggregate"};
+    for (int op = 0; op < 4; op++)
+        std::cout << names[op] << ": " << counts[op] << " ops, "
+          << (long)(counts[op] / std::chrono::duration<double>(times[op]).count()) << " ops/s" << std::endl;
+    // Compare checking for a cycle with two find_roots and a path_aggregate against a single cycle_query
+    std::chrono::nanoseconds separate_time(0), fused_time(0);
+    for (int i = 0; i < num_steps; i++) {
+        node_id_t a = rng() % nodecount, b = rng() % nodecount;
+        auto start = std::chrono::high_resolution_clock::now();
+        if (lct.find_root(a) == lct.find_root(b))
+            checksum += lct.path_aggregate(a, b).second;
+        separate_time += std::chrono::high_resolution_clock::now() - start;
+        a = rng() % nodecount, b = rng() % nodecount;
+        start = std::chrono::high_resolution_clock::now();
+        checksum += lct.cycle_query(a, b).max_weight;
+        fused_time += std::chrono::high_resolution_clock::now() - start;
+    }
+    std::cout << "find_root and path_aggregate: " << (long)(num_steps / std::chrono::duration<double>(separate_time).count()) << " cycle checks/s" << std::endl;
+    std::cout << "cycle_query: " << (long)(num_steps / std::chrono::duration<double>(fused_time).count()) << " cycle checks/s" << std::endl;
+    std::cout << "Checksum: " << checksum << std::endl;
 }
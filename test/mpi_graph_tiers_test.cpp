@@ -15,6 +15,20 @@
 const int DEFAULT_BATCH_SIZE = 100;
 const vec_t DEFAULT_SKETCH_ERR = 1;
 
+// Checks the input node's component sizes against the components it returned
+void expect_component_sizes(InputNode& input_node, const std::vector<std::set<node_id_t>>& cc) {
+    std::vector<node_id_t> sizes;
+    for (const std::set<node_id_t>& component : cc) {
+        sizes.push_back(component.size());
+        for (node_id_t v : component)
+            EXPECT_EQ(input_node.component_size(v), component.size());
+    }
+    std::sort(sizes.begin(), sizes.end(), std::greater<node_id_t>());
+    EXPECT_EQ(input_node.largest_components(cc.size()), sizes);
+    sizes.resize(std::min(sizes.size(), (size_t)3));
+    EXPECT_EQ(input_node.largest_components(3), sizes);
+}
+
 TEST(GraphTierSuite, mpi_update_speed_test) {
     int world_rank_buf;
     MPI_Comm_rank(MPI_COMM_WORLD, &world_rank_buf);
@@ -55,7 +69,7 @@ TEST(GraphTierSuite, mpi_update_speed_test) {
         int seed = time(NULL);
         srand(seed);
         std::cout << "InputNode seed: " << seed << std::endl;
-        InputNode input_node(num_nodes, num_tiers, update_batch_size, seed);
+        InputNode input_node(num_nodes, num_tiers, update_batch_size);
         long edgecount = stream.edges();
         // long count = 100000000;
         // edgecount = std::min(edgecount, count);
@@ -126,7 +140,7 @@ TEST(GraphTiersSuite, mpi_query_speed_test) {
         int seed = time(NULL);
         srand(seed);
         std::cout << "InputNode seed: " << seed << std::endl;
-        InputNode input_node(num_nodes, num_tiers, update_batch_size, seed);
+        InputNode input_node(num_nodes, num_tiers, update_batch_size);
 
         long total_time = 0;
         for (int batch = 0; batch < 10; batch++) {
@@ -197,13 +211,15 @@ TEST(GraphTiersSuite, mpi_mini_correctness_test) {
         int seed = time(NULL);
         srand(seed);
         std::cout << "InputNode seed: " << seed << std::endl;
-        InputNode input_node(num_nodes, num_tiers, update_batch_size, seed);
+        InputNode input_node(num_nodes, num_tiers, update_batch_size);
         MatGraphVerifier gv(num_nodes);
         // Link all of the nodes into 1 connected component
         for (node_id_t i = 0; i < num_nodes-1; i++) {
             input_node.update({{i, i+1}, INSERT});
             gv.edge_update(i,i+1);
             std::vector<std::set<node_id_t>> cc = input_node.cc_query();
+            ASSERT_EQ(input_node.num_components(), cc.size());
+            expect_component_sizes(input_node, cc);
             try {
                 gv.reset_cc_state();
                 gv.verify_soln(cc);
@@ -218,6 +234,8 @@ TEST(GraphTiersSuite, mpi_mini_correctness_test) {
             input_node.update({{i, i+1}, DELETE});
             gv.edge_update(i,i+1);
             std::vector<std::set<node_id_t>> cc = input_node.cc_query();
+            ASSERT_EQ(input_node.num_components(), cc.size());
+            expect_component_sizes(input_node, cc);
             try {
                 gv.reset_cc_state();
                 gv.verify_soln(cc);
@@ -270,7 +288,7 @@ TEST(GraphTiersSuite, mpi_mini_replacement_test) {
         int seed = time(NULL);
         srand(seed);
         std::cout << "InputNode seed: " << seed << std::endl;
-        InputNode input_node(num_nodes, num_tiers, update_batch_size, seed);
+        InputNode input_node(num_nodes, num_tiers, update_batch_size);
         MatGraphVerifier gv(num_nodes);
         // Link all of the nodes into 1 connected component
         for (node_id_t i = 0; i < num_nodes-1; i++) {
@@ -351,7 +369,7 @@ TEST(GraphTiersSuite, mpi_mini_batch_test) {
         int seed = time(NULL);
         srand(seed);
         std::cout << "InputNode seed: " << seed << std::endl;
-        InputNode input_node(num_nodes, num_tiers, update_batch_size, seed);
+        InputNode input_node(num_nodes, num_tiers, update_batch_size);
         MatGraphVerifier gv(num_nodes);
         // Link all of the nodes into 1 connected component
         for (node_id_t i = 0; i < num_nodes-1; i++) {
@@ -484,7 +502,7 @@ TEST(GraphTiersSuite, mpi_correctness_test) {
         int seed = time(NULL);
         srand(seed);
         std::cout << "InputNode seed: " << seed << std::endl;
-        InputNode input_node(num_nodes, num_tiers, update_batch_size, seed);
+        InputNode input_node(num_nodes, num_tiers, update_batch_size);
         MatGraphVerifier gv(num_nodes);
         int edgecount = stream.edges();
 	    int count = 20000000;
@@ -0,0 +1,159 @@
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <sketchless_euler_tour_tree.h>
+
+// A user-defined aggregate, the sum of the weights of the vertices in each tree
+struct WeightAggregate {
+  int64_t weight = 0;
+  static WeightAggregate of_vertex(node_id_t vertex) { return {(int64_t)vertex}; }
+  void add(const WeightAggregate& other) { weight += other.weight; }
+  void subtract(const WeightAggregate& other) { weight -= other.weight; }
+};
+
+inline bool agg_equal(const NoAggregate&, const NoAggregate&) { return true; }
+inline bool agg_equal(const SizeAggregate& a, const SizeAggregate& b) { return a.size == b.size; }
+inline bool agg_equal(const WeightAggregate& a, const WeightAggregate& b) { return a.weight == b.weight; }
+
+template <typename Agg>
+bool AggSkipListNode<Agg>::isvalid() {
+  bool valid = true;
+  if (this->up && this->up->down != this) valid = false;
+  if (this->down && this->down->up != this) valid = false;
+  if (this->left && this->left->right != this) valid = false;
+  if (this->right && this->right->left != this) valid = false;
+  if (this->up && !this->up->isvalid()) valid = false;
+  if (!this->get_parent() && this->right) valid = false;
+  // Aggregates above the bottom level sum the nodes under them
+  if (this->down) {
+    Agg child_agg = this->down->agg();
+    for (AggSkipListNode* child = this->down->right; child && !child->up; child = child->right) {
+      if (child->parent != this) valid = false;
+      child_agg.add(child->agg());
+    }
+    if (!agg_equal(this->agg(), child_agg)) valid = false;
+  }
+  // The cached root and list boundaries must match walking the list
+  AggSkipListNode* root = this;
+  while (root->get_parent()) root = root->get_parent();
+  if (this->get_root() != root) valid = false;
+  AggSkipListNode* first = root;
+  while (first->down) first = first->down;
+  if (root->list_first != first) valid = false;
+  AggSkipListNode* last = root;
+  while (last->right || last->down) last = last->right ? last->right : last->down;
+  if (root->list_last != last) valid = false;
+  return valid;
+}
+
+// Links and cuts random edges of a forest, the same sequence for the same seed
+template <typename Agg>
+class RandomForest {
+  std::mt19937_64 rng;
+  std::vector<std::pair<node_id_t, node_id_t>> edges;
+public:
+  AggEulerTourTree<Agg> ett;
+  node_id_t nodecount;
+
+  RandomForest(node_id_t nodecount, int seed) : rng(seed), ett(nodecount, 0), nodecount(nodecount) {}
+
+  void step(int link_percent) {
+    if (edges.empty() || (int)(rng() % 100) < link_percent) {
+      node_id_t a = rng() % nodecount, b = rng() % nodecount;
+      if (a != b && ett.ett_nodes[a].link(ett.ett_nodes[b]))
+        edges.push_back({a, b});
+    } else {
+      size_t i = rng() % edges.size();
+      ett.cut(edges[i].first, edges[i].second);
+      edges[i] = edges.back();
+      edges.pop_back();
+    }
+  }
+
+  bool isvalid() {
+    for (AggEulerTourNode<Agg>& node : ett.ett_nodes) {
+      AggSkipListNode<Agg>* sentinel = node.get_sentinel();
+      if (!sentinel) continue;
+      for (AggSkipListNode<Agg>* curr = sentinel->get_first(); curr; curr = curr->next())
+        if (!curr->isvalid()) return false;
+    }
+    return true;
+  }
+};
+
+TEST(SketchlessEulerTourTreeSuite, size_aggregate_test) {
+  sketchless_height_factor = 1;
+  node_id_t nodecount = 1000;
+  int seed = time(NULL);
+  std::cout << "Seeding size aggregate test with " << seed << std::endl;
+  RandomForest<SizeAggregate> forest(nodecount, seed);
+  for (int i = 0; i < 20000; i++) {
+    forest.step(60);
+    if (i % 1000 == 0) {
+      ASSERT_TRUE(forest.isvalid()) << "Step " << i;
+      for (node_id_t v = 0; v < nodecount; v++)
+        ASSERT_EQ(forest.ett.get_aggregate(v).size, forest.ett.ett_nodes[v].get_component().size());
+    }
+  }
+}
+
+TEST(SketchlessEulerTourTreeSuite, user_aggregate_test) {
+  sketchless_height_factor = 1;
+  node_id_t nodecount = 500;
+  int seed = time(NULL);
+  std::cout << "Seeding user aggregate test with " << seed << std::endl;
+  srand(seed);
+  RandomForest<WeightAggregate> forest(nodecount, seed);
+  std::vector<int64_t> weights(nodecount);
+  for (node_id_t v = 0; v < nodecount; v++)
+    weights[v] = v;
+  for (int i = 0; i < 20000; i++) {
+    forest.step(60);
+    // Change the weight of a vertex in between
+    node_id_t v = rand() % nodecount;
+    int64_t delta = rand() % 100 - 50;
+    forest.ett.update_aggregate(v, {delta});
+    weights[v] += delta;
+    if (i % 1000 == 0) {
+      ASSERT_TRUE(forest.isvalid()) << "Step " << i;
+      for (node_id_t u = 0; u < nodecount; u++) {
+        int64_t naive_weight = 0;
+        for (AggEulerTourNode<WeightAggregate>* node : forest.ett.ett_nodes[u].get_component())
+          naive_weight += weights[node->vertex];
+        ASSERT_EQ(forest.ett.get_aggregate(u).weight, naive_weight);
+      }
+    }
+  }
+}
+
+template <typename Agg>
+long time_random_forest(node_id_t nodecount, int num_steps, int seed) {
+  RandomForest<Agg> forest(nodecount, seed);
+  std::mt19937_64 query_rng(seed);
+  long connected = 0;
+  auto start = std::chrono::high_resolution_clock::now();
+  for (int i = 0; i < num_steps; i++) {
+    forest.step(55);
+    connected += forest.ett.is_connected(query_rng() % nodecount, query_rng() % nodecount);
+  }
+  auto stop = std::chrono::high_resolution_clock::now();
+  EXPECT_GE(connected, 0);
+  return std::chrono::duration_cast<std::chrono::milliseconds>(stop - start).count();
+}
+
+TEST(SketchlessEulerTourTreeSuite, speed_test) {
+  node_id_t nodecount = 100000;
+  int num_steps = 1000000;
+  int seed = time(NULL);
+  double prev_height_factor = sketchless_height_factor;
+  sketchless_height_factor = 1./log2(log2(nodecount));
+  std::cout << "sizeof(AggSkipListNode<NoAggregate>): " << sizeof(AggSkipListNode<NoAggregate>) << std::endl;
+  std::cout << "sizeof(AggSkipListNode<SizeAggregate>): " << sizeof(AggSkipListNode<SizeAggregate>) << std::endl;
+  std::cout << "NoAggregate links, cuts and queries (ms): " << time_random_forest<NoAggregate>(nodecount, num_steps, seed) << std::endl;
+  std::cout << "SizeAggregate links, cuts and queries (ms): " << time_random_forest<SizeAggregate>(nodecount, num_steps, seed) << std::endl;
+  sketchless_height_factor = prev_height_factor;
+}
@@ -11,6 +11,23 @@ bool SkipListNode::isvalid() {
 	if (this->right && this->right->left != this) valid = false;
     if (this->up && !this->up->isvalid()) valid = false;
     if (!this->get_parent() && this->right) valid = false;
+    // Sizes above the bottom level count the bottom nodes under them
+    if (this->down) {
+        uint32_t child_size = this->down->size;
+        for (SkipListNode* child = this->down->right; child && !child->up; child = child->right)
+            child_size += child->size;
+        if (this->size != child_size) valid = false;
+    }
+    // The cached root and list boundaries must match walking the list
+    SkipListNode* root = this;
+    while (root->get_parent()) root = root->get_parent();
+    if (this->get_root() != root) valid = false;
+    SkipListNode* first = root;
+    while (first->down) first = first->down;
+    if (root->list_first != first) valid = false;
+    SkipListNode* last = root;
+    while (last->right || last->down) last = last->right ? last->right : last->down;
+    if (root->list_last != last) valid = false;
 	return valid;
 }
 
@@ -32,7 +49,7 @@ int SkipListNode::print_list() {
 }
 
 bool aggregate_correct(SkipListNode* node) {
-    Sketch* naive_agg = new Sketch(sketch_len, node->node->get_seed(), 1, sketch_err);
+    Sketch* naive_agg = new Sketch(sketch_len, node->node->get_sketch_pool()->get_seed(), 1, sketch_err);
     std::set<EulerTourNode*> component = node->get_component();
     for (auto ett_node : component) {
         naive_agg->update(ett_node->vertex);
@@ -82,3 +99,57 @@ TEST(SkipListSuite, join_split_test) {
         ASSERT_TRUE(aggregate_correct(nodes[i])) << "Node " << i << " agg incorrect";
     }
 }
+
+TEST(SkipListSuite, excise_test) {
+    int num_elements = 200;
+    sketch_len = num_elements*num_elements;
+    sketch_err = 100;
+
+    long seed = time(NULL);
+    srand(seed);
+    std::cout << "Seeding excise test with " << seed << std::endl;
+    // Use real towers so elements are cut out of several levels
+    double prev_height_factor = height_factor;
+    height_factor = 1;
+    EulerTourTree ett(num_elements, 0, seed);
+    std::vector<SkipListNode*> nodes;
+    for (int i = 0; i < num_elements; i++) {
+        ett.update_sketch(i, (vec_t)i);
+        nodes.push_back(ett.ett_nodes[i].allowed_caller);
+    }
+    for (int i = 0; i < num_elements-1; i++) SkipListNode::join(nodes[i], nodes[i+1]);
+
+    // Checks every aggregate above the bottom level is the sum of its children
+    auto all_aggregates_correct = [&](SkipListNode* root) {
+        for (SkipListNode* level = root; level->down; level = level->down) {
+            for (SkipListNode* curr = level; curr; curr = curr->right) {
+                Sketch expected(sketch_len, seed, 1, sketch_err);
+                SkipListNode* child = curr->down;
+                do {
+                    child->process_updates();
+                    if (child->sketch_agg) expected.merge(*child->sketch_agg);
+                    child = child->right;
+                } while (child && !child->up);
+                curr->process_updates();
+                if (!(expected == *curr->get_sketch())) return false;
+            }
+        }
+        return true;
+    };
+
+    // Cut random elements out of the middle, the ends and the front of the list
+    while (nodes.size() > 1) {
+        size_t idx = rand() % nodes.size();
+        SkipListNode* root = SkipListNode::excise(nodes[idx]);
+        nodes[idx]->uninit_element(false);
+        nodes.erase(nodes.begin() + idx);
+        ASSERT_EQ(root->size, nodes.size()+1);
+        ASSERT_TRUE(all_aggregates_correct(root));
+        for (SkipListNode* node : nodes) {
+            ASSERT_EQ(node->get_root(), root);
+            ASSERT_TRUE(node->isvalid());
+        }
+        ASSERT_TRUE(aggregate_correct(nodes[0]));
+    }
+    height_factor = prev_height_factor;
+}